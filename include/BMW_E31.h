@@ -37,7 +37,6 @@ public:
    void SetCanInterface(CanHardware* c);
    void Task10Ms();
    void Task100Ms();
-   void Task1Ms();
    void SetRevCounter(int s);
    void SetTemperatureGauge(float temp);
    void DecodeCAN(int id, uint32_t* data);
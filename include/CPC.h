@@ -39,8 +39,6 @@ class CPCClass: public Chargerint
 public:
       void SetCanInterface(CanHardware* c);
       void DecodeCAN(int id, uint32_t data[2]);
-      void Task10Ms();
-      void Task100Ms();
       void Task200Ms();
       bool DCFCRequest(bool RunCh);
       bool ACRequest(bool RunCh);
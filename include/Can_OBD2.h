@@ -21,15 +21,26 @@
 #define Can_OBD2_h
 
 #include "stm32_can.h"
+#include "isotp.h"
 
 class Can_OBD2
 {
 public:
   void SetCanInterface(CanHardware *c);
   void DecodeCAN(int id, uint32_t data[2]);
+  void Task1Ms() { isotp.Task1Ms(); }
 
 protected:
   CanHardware *can;
+
+private:
+  void ProcessRequest(const uint8_t *request, int len);
+  int Mode1Response(const uint8_t *request, int len, uint8_t *response);
+  int Mode9Response(uint8_t pid, uint8_t *response);
+  int ReadDataByIdResponse(const uint8_t *request, int len, uint8_t *response);
+  int GetMode1Pid(uint8_t pid, uint8_t *response);
+
+  IsoTp isotp;
 };
 
 #endif /* Can_OBD2_h */
@@ -33,7 +33,6 @@ class E65_Lever: public Shifter
 public:
 
 
-   void Task10Ms();
    void Task100Ms();
    void DecodeCAN(int, uint32_t*);
    bool GetGear(Shifter::Sgear& outGear);//if shifter class knows gear return true and set dir
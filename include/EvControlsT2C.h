@@ -28,7 +28,6 @@ public:
    EvControlsT2C();
    void SetCanInterface(CanHardware* c);
    void DecodeCAN(int id, uint32_t data[2]);
-   void Task10Ms();
    void Task100Ms();
    void SetTorque(float torque);
    float GetMotorTemperature() { return motor_temp; }
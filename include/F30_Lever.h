@@ -35,7 +35,6 @@ class F30_Lever: public Shifter
 public:
 
 
-   void Task10Ms();
    void Task100Ms();
    void DecodeCAN(int, uint32_t*);
    bool GetGear(Shifter::Sgear& outGear);//if shifter class knows gear return true and set dir
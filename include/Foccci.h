@@ -45,7 +45,6 @@ public:
       void DecodeCAN(int id, uint32_t data[2]);
       void Task10Ms();
       void Task100Ms();
-      void Task200Ms();
       void ConfigCan();
       bool DCFCRequest(bool RunCh);
       bool ACRequest(bool RunCh);
@@ -32,6 +32,8 @@ class OutlanderCanHeater : public Heater
       void DecodeCAN(int id, uint32_t data[2]);
       void SetPower(uint16_t power, bool HeatReq);
       void Task100Ms();
+      bool IsIdle() { return !shouldHeat; }
+      bool HasTemperature() { return true; }
 
    private:
       int8_t currentTemperature;
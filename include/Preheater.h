@@ -22,28 +22,45 @@
 #include <stdint.h>
 #include "params.h"
 
+/* Timed preconditioning. At Pre_Hrs:Pre_Min the heater runs for Pre_Dur
+ * minutes, HV is brought up for it if the car is off. Heat is requested
+ * until tmpheater reaches HeatTargetTemp and again once it has dropped by
+ * PREHEAT_HYST. Heaters that don't report tmpheater are not preheated, the
+ * demand could never end. Starting the car ends the preheat.
+ */
+
+#define PREHEAT_HYST 5 //°C
+
 class Preheater 
 {
 public:
    Preheater();
-    void Task200Ms(int opmode, unsigned hours, unsigned minutes);
+    /** @param hasTemperature true if the selected heater reports tmpheater */
+    void Task200Ms(int opmode, unsigned hours, unsigned minutes, bool hasTemperature);
     void Ms10Task();
+    void Stop();
     void ParamsChange();
     void SetInitByPreHeat(bool initbyPH);
 
     bool GetRunPreHeat();
     bool GetInitByPreHeat();
+    bool GetHeatDemand();
+    /** @return seconds until the next preheat starts, 0 if the timer isn't armed */
+    uint32_t GetStartDelay(unsigned hours, unsigned minutes, unsigned seconds);
 
 private:
+    bool HeaterUsable();
+
     //Preheat matching the charger timer
     uint8_t PreHeatSet;
     bool RunPreHeat;
     uint32_t PreheatTicks;
-    uint32_t PreheatTicks_1Min;
     uint8_t PreHeatHrs_tmp;
     uint8_t PreHeatMins_tmp;
     uint16_t PreHeatDur_tmp;
     bool initbyPreHeat;
+    bool heatDemand;
+    bool heaterTemp;
 };
 
 #endif // PREHEATER_H
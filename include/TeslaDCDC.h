@@ -33,10 +33,12 @@ class TeslaDCDC: public DCDC
       void DeInit() {};
       void Task100Ms();
       void SetCanInterface(CanHardware* c);
+      bool IsIdle();
    protected:
       CanHardware* can;
    private:
       uint8_t timer500=0;
+      uint8_t current=0;
 };
 #endif // TeslaDCDC_H
 
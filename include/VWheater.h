@@ -23,7 +23,7 @@
 
 //#include <libopencm3/stm32/usart.h>
 #include <heater.h>
-#include "linbus.h"
+#include "linmaster.h"
 
 
 class vwHeater : public Heater
@@ -31,11 +31,10 @@ class vwHeater : public Heater
    public:
       void SetTargetTemperature(float temp) { (void)temp; } //Not supported (yet)?
       void SetPower(uint16_t power, bool HeatReq);
-      void SetLinInterface(LinBus* l);
-
-   private:
-      bool isAwake=false;
-      LinBus* lin;
+      void SetLinInterface(); //starts the LIN schedule
+      void DeInit();
+      bool IsIdle();
+      bool HasTemperature() { return true; }
 };
 
 #endif // VWHEATER_H
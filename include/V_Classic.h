@@ -32,9 +32,7 @@ class V_Classic: public Vehicle
 
 public:
    void SetCanInterface(CanHardware* c);
-   void Task10Ms();
    void Task100Ms();
-   void Task1Ms();
    void SetRevCounter(int s);
    void SetTemperatureGauge(float temp);
    bool Ready();
@@ -23,6 +23,8 @@
 #include <heater.h>
 
 
+//Doesn't report the coolant temperature, so it runs open loop at HeatPwr
+//(ramped by HeatRamp) and isn't used for preheating.
 class AmperaHeater : public Heater
 {
    public:
@@ -30,6 +32,7 @@ class AmperaHeater : public Heater
       AmperaHeater();
       void SetTargetTemperature(float temp) { (void)temp; } //Not supported (yet)?
       void SetPower(uint16_t power, bool HeatReq);
+      bool IsIdle() { return !isAwake; }
 
    private:
       bool isAwake=false;
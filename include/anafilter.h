@@ -0,0 +1,79 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANAFILTER_H
+#define ANAFILTER_H
+
+/* Second filter stage of the analogue inputs. AnaIn keeps ADC1 scanning all
+ * inputs into a circular DMA buffer and averages the last NUM_SAMPLES
+ * conversions of a channel. Run() takes that average at a rate set per channel
+ * in anafilter_prj.h and passes it through
+ * - a sliding median that removes single sample spikes
+ * - decimation, averaging that many medians into one result.
+ * Each result carries the time of its newest sample. The first sample is
+ * published right away so nothing reads 0 after boot.
+ * The scan itself is shared by all inputs, so the rates are set here, not
+ * in the ADC.
+ */
+
+#include <stdint.h>
+#include "anafilter_prj.h"
+
+#define ANAFILTER_PERIOD_MS   1 //Run() call interval
+#define ANAFILTER_MAX_MEDIAN  5
+
+class AnaFilter
+{
+public:
+    AnaFilter(uint8_t periodMs, uint8_t median, uint8_t decimation);
+
+    /** @return true if a sample is due, call every ANAFILTER_PERIOD_MS */
+    bool Due();
+    /** Feeds one raw sample taken at time now (ms) */
+    void Sample(uint16_t raw, uint32_t now);
+    /** @return latest filtered value */
+    uint16_t Get() const { return value; }
+    /** @return time in ms of the newest sample in Get() */
+    uint32_t GetTime() const { return time; }
+
+    /** Samples all channels from AnaIn, call every ANAFILTER_PERIOD_MS */
+    static void Run();
+
+    #define ANAFILTER_ENTRY(name, period, median, decimation) static AnaFilter name;
+    ANAFILTER_LIST
+    #undef ANAFILTER_ENTRY
+
+private:
+    uint16_t Median();
+
+    uint8_t periodMs;
+    uint8_t medianLen;
+    uint8_t decimation;
+    uint8_t tick;
+    uint16_t window[ANAFILTER_MAX_MEDIAN];
+    uint8_t filled;
+    uint8_t pos;
+    uint32_t sum;
+    uint8_t summed;
+    bool valid;
+    volatile uint16_t value;
+    volatile uint32_t time;
+
+    static uint32_t now;
+};
+
+#endif // ANAFILTER_H
@@ -0,0 +1,34 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANAFILTER_PRJ_H_INCLUDED
+#define ANAFILTER_PRJ_H_INCLUDED
+
+//One entry per ANA_IN_LIST entry of the same name:
+//name, sample period in ms, median length (1..ANAFILTER_MAX_MEDIAN), decimation.
+//Results come at 1000 / (period * decimation) Hz.
+#define ANAFILTER_LIST \
+   ANAFILTER_ENTRY(throttle1,  1,   3, 1)  /* 1kHz */ \
+   ANAFILTER_ENTRY(throttle2,  1,   3, 1)  \
+   ANAFILTER_ENTRY(uaux,       10,  3, 10) /* 10Hz */ \
+   ANAFILTER_ENTRY(GP_analog1, 5,   3, 2)  /* 100Hz, pilot/proximity, brake vacuum, selectors */ \
+   ANAFILTER_ENTRY(GP_analog2, 5,   3, 2)  \
+   ANAFILTER_ENTRY(MG1_Temp,   10,  5, 10) /* 10Hz */ \
+   ANAFILTER_ENTRY(MG2_Temp,   10,  5, 10) \
+   ANAFILTER_ENTRY(dummyAnal,  100, 1, 1)  \
+
+#endif // ANAFILTER_PRJ_H_INCLUDED
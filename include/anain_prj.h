@@ -22,8 +22,11 @@
 
 #include "hwdefs.h"
 
+//ADC1 scans continuously, AnaIn averages the last NUM_SAMPLES conversions of an input.
+//28.5 cycles let the sample capacitor settle on the kOhm sensor dividers, a scan of all
+//inputs still takes about 30us. Rates, medians and decimation are in anafilter_prj.h
 #define NUM_SAMPLES 12
-#define SAMPLE_TIME ADC_SMPR_SMP_7DOT5CYC
+#define SAMPLE_TIME ADC_SMPR_SMP_28DOT5CYC
 
 #define ANA_IN_LIST \
    ANA_IN_ENTRY(throttle1, GPIOC, 0) \
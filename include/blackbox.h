@@ -0,0 +1,87 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BLACKBOX_H
+#define BLACKBOX_H
+
+/* RAM resident pre/post trigger recorder. A fixed set of values is sampled
+ * every 10ms into a ring buffer. When a trigger fires, BB_POST_SAMPLES more
+ * samples are taken and the buffer is then frozen until it is re-armed from
+ * the terminal ("blackbox arm") or via SDO.
+ */
+
+#include <stdint.h>
+#include "params.h"
+#include "printf.h"
+#include "cansdo.h"
+
+#define BB_SAMPLES        64  //64 x 10ms = 640ms window
+#define BB_POST_SAMPLES   16  //samples recorded after the trigger, the rest is pre-trigger history
+#define BB_SDO_INDEX      0x4100
+#define BB_HEADER_SIZE    8
+
+#define BB_SIGNAL_LIST \
+    BB_SIGNAL_ENTRY(opmode,     1) \
+    BB_SIGNAL_ENTRY(dir,        1) \
+    BB_SIGNAL_ENTRY(status,     1) \
+    BB_SIGNAL_ENTRY(TorqDerate, 1) \
+    BB_SIGNAL_ENTRY(din_brake,  1) \
+    BB_SIGNAL_ENTRY(T15Stat,    1) \
+    BB_SIGNAL_ENTRY(pot,        1) \
+    BB_SIGNAL_ENTRY(pot2,       1) \
+    BB_SIGNAL_ENTRY(potnom,     10) \
+    BB_SIGNAL_ENTRY(torque,     1) \
+    BB_SIGNAL_ENTRY(speed,      1) \
+    BB_SIGNAL_ENTRY(udc,        10) \
+    BB_SIGNAL_ENTRY(udc2,       10) \
+    BB_SIGNAL_ENTRY(idc,        1) \
+    BB_SIGNAL_ENTRY(tmphs,      1) \
+    BB_SIGNAL_ENTRY(tmpm,       1) \
+
+class BlackBox
+{
+public:
+    enum state { ARMED, TRIGGERED, FROZEN };
+    enum reason { TRG_NONE, TRG_PRECHARGE, TRG_OVERVOLTAGE, TRG_RUNDROP, TRG_CANTIMEOUT, TRG_MANUAL };
+
+    static void Sample(); //Must be called every 10ms
+    static void Trigger(reason r);
+    static void Arm();
+    static void Print(IPutChar* out);
+    static bool ProcessSdo(CanSdo::SdoFrame* sdo);
+    static uint32_t GetRecordSize();
+    static uint32_t ReadRecord(uint32_t offset, uint8_t* data, uint32_t len);
+    static state GetState() { return bbState; }
+
+private:
+    #define BB_SIGNAL_ENTRY(name, scale) SIG_##name,
+    enum signals { BB_SIGNAL_LIST SIG_LAST };
+    #undef BB_SIGNAL_ENTRY
+
+    static int32_t GetSample(int sample, int signal);
+
+    static int16_t buffer[BB_SAMPLES][SIG_LAST];
+    static uint8_t writeIdx;
+    static uint8_t postCount;
+    static uint8_t lastOpmode;
+    static uint16_t numSamples;
+    static uint32_t triggerTime;
+    static state bbState;
+    static reason bbReason;
+};
+
+#endif // BLACKBOX_H
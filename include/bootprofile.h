@@ -0,0 +1,73 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BOOTPROFILE_H
+#define BOOTPROFILE_H
+
+/* Boot time profile. Start() resets the DWT cycle counter as the first thing
+ * in main(), Mark() adds the time since the previous Mark() to a stage. A
+ * stage can be marked more than once, e.g. when lazily initialised hardware
+ * interrupts the device setup, the times add up. Registering the device CAN
+ * messages and filters is a stage of its own, so the cost of every rebuild
+ * during the device setup shows up there. Finish() ends the profile, later
+ * marks are ignored. FirstCan() records the time of the first CAN message
+ * received from a device.
+ * Times are counted in the clock that was running when the stage started, so
+ * the clock stage is counted at HSI speed. Time spent before main() (copying
+ * .data, zeroing .bss) is not included.
+ */
+
+#include <stdint.h>
+#include "printf.h"
+
+#define BOOT_STAGE_LIST \
+    BOOT_STAGE_ENTRY(BOOT_STACK,    "stack") \
+    BOOT_STAGE_ENTRY(BOOT_CLOCK,    "clock") \
+    BOOT_STAGE_ENTRY(BOOT_HWINIT,   "hwinit") \
+    BOOT_STAGE_ENTRY(BOOT_PARAMS,   "params") \
+    BOOT_STAGE_ENTRY(BOOT_CAN,      "can") \
+    BOOT_STAGE_ENTRY(BOOT_DEVICES,  "devices") \
+    BOOT_STAGE_ENTRY(BOOT_CAN3,     "can3") \
+    BOOT_STAGE_ENTRY(BOOT_LIN,      "lin") \
+    BOOT_STAGE_ENTRY(BOOT_CANFILT,  "canfilters") \
+    BOOT_STAGE_ENTRY(BOOT_SCHED,    "scheduler") \
+    BOOT_STAGE_ENTRY(BOOT_DEFERRED, "deferred")
+
+#define BOOT_STAGE_ENTRY(stage, name) stage,
+enum BootStage { BOOT_STAGE_LIST BOOT_STAGE_NUM };
+#undef BOOT_STAGE_ENTRY
+
+class BootProfile
+{
+public:
+    static void Start(); //call first thing in main()
+    static void Mark(BootStage stage);
+    static void Finish();
+    static void FirstCan(); //call on received CAN messages
+    static void Print(IPutChar* out);
+
+private:
+    static uint32_t Elapsed();
+
+    static uint32_t stageUs[BOOT_STAGE_NUM];
+    static uint32_t lastCycles;
+    static uint32_t totalUs;
+    static uint32_t firstCanUs;
+    static bool running;
+};
+
+#endif // BOOTPROFILE_H
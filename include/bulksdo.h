@@ -0,0 +1,119 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BULKSDO_H
+#define BULKSDO_H
+
+/* Second SDO server channel for bulk transfers. It implements CANopen
+ * segmented and block upload/download (no CRC) for large objects that
+ * the expedited only CanSdo on node 3 can't serve in one go.
+ *
+ * Objects:
+ * 0x5000 sub 0: parameter set, records of uint16 id + int32 raw value (little endian).
+ *               Upload returns all parameters and values, download sets parameters.
+ * 0x5001 sub 0: black box recording, see BlackBox::ReadRecord(). Upload only.
+ * 0x5002 sub 0: fault history, see FaultLog::ReadRecord(). Upload only.
+ *
+ * Frames are queued by the CAN interrupt and the transfer runs entirely in
+ * Task1Ms(). Parameter writes are applied from the main loop, like terminal
+ * commands, as Param::Change() may rebuild device drivers. Out of range
+ * values are skipped there. Block downloads use a block size that fits the
+ * receive queue.
+ *
+ * See tools/sdo_bulk.py for a host side client.
+ */
+
+#include <stdint.h>
+#include "canhardware.h"
+#include "params.h"
+
+#define BULKSDO_NODEID         4
+#define BULKSDO_REQ_ID         (0x600 + BULKSDO_NODEID)
+#define BULKSDO_REP_ID         (0x580 + BULKSDO_NODEID)
+#define BULKSDO_MAX_BLKSIZE    127
+#define BULKSDO_FRAMES_PER_MS  2    //block upload pacing, roughly 50% bus load at 500kbit
+#define BULKSDO_TIMEOUT_MS     1000
+#define BULKSDO_RXQUEUE_SIZE   16   //request frames buffered between the CAN interrupt and Task1Ms()
+#define BULKSDO_WRQUEUE_SIZE   16   //parameter writes waiting for the main loop
+
+class BulkSdo
+{
+    BulkSdo();
+    ~BulkSdo();
+
+public:
+    static void RegisterCanMessages(CanHardware* can);
+    static void DecodeCAN(int id, uint32_t data[2]); //only queues the frame for Task1Ms()
+    static void Task1Ms();
+    static void Run(); //call from main loop, applies parameter writes
+
+private:
+    struct Object
+    {
+        uint16_t index;
+        uint32_t (*GetSize)();
+        uint32_t (*Read)(uint32_t offset, uint8_t* data, uint32_t len);
+        bool (*Write)(uint32_t offset, const uint8_t* data, uint32_t len);
+    };
+
+    enum xferstate { IDLE, UPLOAD_SEG, DOWNLOAD_SEG, BLKUP_INIT, BLKUP_SEND, BLKUP_WAITACK, BLKUP_END, BLKDN_RECV, BLKDN_END };
+
+    struct ParamWriteReq
+    {
+        Param::PARAM_NUM idx;
+        int32_t value;
+    };
+
+    static void ProcessFrame(uint8_t* bytes);
+    static void InitiateUpload(uint8_t* bytes);
+    static void UploadSegment(uint8_t* bytes);
+    static void InitiateDownload(uint8_t* bytes);
+    static void DownloadSegment(uint8_t* bytes);
+    static void BlockUpload(uint8_t* bytes);
+    static void BlockDownload(uint8_t* bytes);
+    static void BlockDownloadSegment(uint8_t* bytes);
+    static const Object* FindObject(uint8_t* bytes);
+    static void Reply(uint8_t cmd, uint32_t data);
+    static void Abort(uint32_t code);
+
+    static uint32_t ParamSize();
+    static uint32_t ParamRead(uint32_t offset, uint8_t* data, uint32_t len);
+    static bool ParamWrite(uint32_t offset, const uint8_t* data, uint32_t len);
+
+    static const Object objects[];
+    static CanHardware* can;
+    static const Object* object;
+    static volatile xferstate state;
+    static uint32_t size;
+    static uint32_t offset;
+    static uint32_t blockStart;
+    static uint8_t toggle;
+    static uint8_t seqno;
+    static uint8_t blksize;
+    static uint8_t lastSegment[7];
+    static uint16_t index;
+    static uint8_t subIndex;
+    static uint16_t timeout;
+    static uint32_t rxQueue[BULKSDO_RXQUEUE_SIZE][2];
+    static volatile uint8_t rxHead;
+    static volatile uint8_t rxTail;
+    static ParamWriteReq wrQueue[BULKSDO_WRQUEUE_SIZE];
+    static volatile uint8_t wrHead;
+    static volatile uint8_t wrTail;
+};
+
+#endif // BULKSDO_H
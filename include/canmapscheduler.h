@@ -0,0 +1,77 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CANMAPSCHEDULER_H
+#define CANMAPSCHEDULER_H
+
+/* Sits between CanMap and the CAN peripheral and decides per CAN id when a
+ * mapped message actually goes on the bus. CanMap packs all messages every
+ * 10ms, each id is then forwarded at its configured period (CanMapRate or
+ * CanMapIdN/CanMapRateN) or, in on-change mode, when its payload changed but
+ * no faster than the period and at least once a second. Messages sharing a
+ * period are spread over different 10ms ticks.
+ * Ids are tracked as long as CanMap sends them, beyond CANMAP_SCHED_MAX_MSG
+ * ids the rest go out every 100ms.
+ * Receive registrations and callbacks are passed through to the hardware.
+ */
+
+#include <stdint.h>
+#include "canhardware.h"
+#include "canmap.h"
+
+#define CANMAP_SCHED_MAX_MSG    16
+#define CANMAP_SCHED_NUM_IDS    4
+#define CANMAP_SCHED_KEEPALIVE  100 //ticks, on-change messages are refreshed after 1s
+#define CANMAP_SCHED_FALLBACK   10  //ticks, period of ids that don't fit the table
+#define CANMAP_SCHED_WRAP       60000 //ticks, multiple of all periods so the phases survive the wrap
+
+class CanMapScheduler : public CanHardware, public CanCallback
+{
+public:
+    CanMapScheduler(CanHardware* hw);
+    void Run(CanMap* map); //call every 10ms
+    using CanHardware::Send;
+    void Send(uint32_t canId, uint32_t data[2], uint8_t len);
+    void SetBaudrate(enum baudrates baudrate);
+    bool HandleRx(uint32_t canId, uint32_t data[2], uint8_t dlc);
+    void HandleClear();
+    uint32_t GetSentFrames() { return sentFrames; }
+
+protected:
+    void ConfigureFilters();
+
+private:
+    struct Message
+    {
+        uint32_t canId;
+        uint32_t data[2];
+        uint16_t lastSent;
+        uint8_t slot;
+        bool seen;
+    };
+
+    int GetRate(uint32_t canId);
+    uint8_t FreeSlot();
+
+    CanHardware* hw;
+    Message messages[CANMAP_SCHED_MAX_MSG];
+    int numMessages;
+    uint16_t tick;
+    uint32_t sentFrames;
+};
+
+#endif // CANMAPSCHEDULER_H
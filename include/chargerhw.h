@@ -34,6 +34,7 @@ public:
    virtual void DeInit() {} //called when switching to another charger, similar to a destructor
    virtual void SetCanInterface(CanHardware* c) { can = c; }
    virtual bool testa(bool) {return false;};
+   virtual bool IsIdle() { return true; } //true when no longer drawing from HV, default has no way of knowing
 
 protected:
    CanHardware* can;
@@ -0,0 +1,127 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONTACTORSEQ_H
+#define CONTACTORSEQ_H
+
+/* Contactor sequencing. Each topology has a table of sequences, one per
+ * opmode transition. A sequence is a list of steps, each step drives a set of
+ * contactors and is left when it has lasted at least minMs and its conditions
+ * are met. If all of its finishEarly conditions are met it doesn't wait for
+ * minMs, so minMs becomes an upper bound for waiting on other devices. A step
+ * still waiting for its conditions after maxMs flags a fault, 0 means no
+ * limit. The outputs of the last step stay until the next
+ * transition. Run() is called every CTS_PERIOD_MS with the current opmode.
+ * Completed steps are recorded with their duration in a log shared by all
+ * sequencers.
+ */
+
+#include <stdint.h>
+
+#define CTS_PERIOD_MS   10
+#define CTS_LOG_SIZE    16
+#define CTS_ANY         0xFF //matches any previous opmode
+
+class ContactorSeq
+{
+public:
+    enum Output
+    {
+        CT_PRECHARGE = 1,
+        CT_NEGATIVE = 2,
+        CT_MAIN = 4,
+        CT_ALL = CT_PRECHARGE | CT_NEGATIVE | CT_MAIN,
+        CT_HOLD = 0x80 //keep what was driven when the sequence started
+    };
+
+    enum Condition
+    {
+        CTC_NONE = 0,
+        CTC_CURRENT_LOW = 1,  //no current flowing, safe to open
+        CTC_DEVICES_IDLE = 2  //HV devices have wound down
+    };
+
+    enum Topology
+    {
+        TOP_LOCAL,        //contactors on our own outputs
+        TOP_LOCAL_NONEG,  //same without a negative contactor
+        TOP_SBOX,         //BMW S-box
+        TOP_VWBOX,        //VW contactor box
+        TOP_HVCU,         //HVCU contactor box
+        TOP_LAST
+    };
+
+    struct Step
+    {
+        uint8_t outputs;
+        uint8_t conditions;
+        uint16_t minMs;
+        uint16_t maxMs;
+        uint8_t finishEarly;
+    };
+
+    struct Sequence
+    {
+        uint8_t from;
+        uint8_t to;
+        const Step* steps;
+        uint8_t numSteps;
+    };
+
+    struct LogEntry
+    {
+        uint8_t topology;
+        uint8_t opmode;
+        uint8_t step;
+        uint16_t ms;
+    };
+
+    ContactorSeq(Topology t);
+    void SetTopology(Topology t);
+    /** @param conditions Condition flags that are currently true
+     * @return contactors to drive, Output flags */
+    uint8_t Run(int opmode, uint8_t conditions);
+    uint8_t GetOutputs() const { return outputs; }
+    /** @return true once the last step of the sequence is complete */
+    bool IsDone() const { return step >= numSteps; }
+    /** @return true if a step exceeded its maxMs */
+    bool HasFault() const { return fault; }
+    uint8_t GetStep() const { return step; }
+    uint16_t GetStepTime() const { return stepTime; }
+
+    /** @return the i-th most recent log entry, 0 if there is none */
+    static const LogEntry* GetLog(int i);
+
+private:
+    void Start(int opmode);
+
+    Topology topology;
+    uint8_t opmode;
+    const Step* steps;
+    uint8_t numSteps;
+    uint8_t step;
+    uint8_t outputs;
+    uint8_t held;
+    uint16_t stepTime;
+    bool fault;
+
+    static LogEntry log[CTS_LOG_SIZE];
+    static uint8_t logPos;
+    static uint8_t logCount;
+};
+
+#endif // CONTACTORSEQ_H
@@ -32,6 +32,7 @@ class DCDC
       virtual void Task10Ms() {};
       virtual void Task100Ms() {};
       virtual void SetCanInterface(CanHardware* c) { can = c; }
+      virtual bool IsIdle() { return true; } //true when no longer drawing from HV
    protected:
       CanHardware* can;
 };
@@ -0,0 +1,111 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DEVICESLOT_H
+#define DEVICESLOT_H
+
+/* Storage for exactly one device object of a category, sized and aligned for
+ * the largest of the listed implementations. Create<T>() constructs T in
+ * place, replacing whatever was there before. Objects are never destroyed,
+ * the previous device must be torn down with DeInit() and must no longer be
+ * reachable from the tasks before calling Create().
+ * Storage is zeroed before construction so members that the constructor
+ * leaves alone start out like they did for statically allocated objects.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <new>
+#include "devicetasks.h"
+
+template <class... T> struct DeviceSlotSize;
+
+template <class T> struct DeviceSlotSize<T>
+{
+   static const size_t size = sizeof(T);
+   static const size_t align = alignof(T);
+};
+
+template <class T, class... R> struct DeviceSlotSize<T, R...>
+{
+   static const size_t size = sizeof(T) > DeviceSlotSize<R...>::size ? sizeof(T) : DeviceSlotSize<R...>::size;
+   static const size_t align = alignof(T) > DeviceSlotSize<R...>::align ? alignof(T) : DeviceSlotSize<R...>::align;
+};
+
+template <class T, class... R> struct DeviceSlotFirst { typedef T type; };
+
+/* The first implementation is the "none" device that is selected while the
+ * slot is empty, Has() reports its tasks then.
+ */
+template <class Base, class... Impl>
+class DeviceSlot
+{
+public:
+   DeviceSlot() : obj(0), tag(0), tasks(NoneTasks) {}
+
+   template <class T> T* Create()
+   {
+      static_assert(sizeof(T) <= sizeof(storage) && alignof(T) <= Align, "Type not listed for this slot");
+
+      Clear();
+      //Make sure the stores above happen before the storage is overwritten
+      __asm__ volatile("" ::: "memory");
+      memset(storage, 0, sizeof(storage));
+      T* t = new (storage) T();
+      //... and the object is complete before anyone gets to see it
+      __asm__ volatile("" ::: "memory");
+      obj = t;
+      tag = Tag<T>();
+      tasks = DeviceTasks<T, Base>::mask;
+      return t;
+   }
+
+   /** Marks the slot empty, Get() returns 0 until the next Create() */
+   void Clear() { tag = 0; tasks = NoneTasks; }
+
+   /** @return true if the device does something in the given task */
+   bool Has(DeviceTask task) const { return tasks & task; }
+
+   /** @return the object if it is of type T, otherwise 0 */
+   template <class T> T* Get() const
+   {
+      return tag == Tag<T>() ? static_cast<T*>(obj) : 0;
+   }
+
+   static const bool IsFixed = false;
+   static const int Selection = -1; //taken from the selection parameter
+   static const size_t Size = DeviceSlotSize<Impl...>::size;
+   static const size_t Align = DeviceSlotSize<Impl...>::align;
+
+private:
+   //Stands in for RTTI which we compile without
+   template <class T> static const void* Tag()
+   {
+      static const char tag = 0;
+      return &tag;
+   }
+
+   static const uint8_t NoneTasks = DeviceTasks<typename DeviceSlotFirst<Impl...>::type, Base>::mask;
+
+   alignas(Align) uint8_t storage[Size];
+   Base* obj;
+   const void* volatile tag;
+   volatile uint8_t tasks;
+};
+
+#endif // DEVICESLOT_H
@@ -0,0 +1,65 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DEVICETASKS_H
+#define DEVICETASKS_H
+
+/* Which periodic tasks a device class actually implements. A task counts if
+ * the class overrides it or the default of its base class does something.
+ * This is evaluated at compile time when a slot constructs a device, the
+ * scheduler tasks then skip devices that would only run an empty default.
+ */
+
+#include <stdint.h>
+#include <type_traits>
+
+enum DeviceTask
+{
+   DEVTASK_1MS = 1,
+   DEVTASK_10MS = 2,
+   DEVTASK_100MS = 4,
+   DEVTASK_200MS = 8
+};
+
+//Tasks that do something in the base class itself
+template <class Base> struct DeviceTaskDefaults { static const uint8_t mask = 0; };
+
+class BMS;
+template <> struct DeviceTaskDefaults<BMS> { static const uint8_t mask = DEVTASK_100MS; }; //publishes "no limits"
+
+//&T::fn has type void (Base::*)() unless T or a class in between overrides it
+#define DEVICE_TASK_TRAIT(fn, bit) \
+template <class T, class Base, class = void> struct DeviceTask##fn { static const uint8_t mask = 0; }; \
+template <class T, class Base> struct DeviceTask##fn<T, Base, decltype((void)&T::fn)> \
+{ \
+   static const uint8_t mask = std::is_same<decltype(&T::fn), void (Base::*)()>::value ? \
+                               (DeviceTaskDefaults<Base>::mask & bit) : bit; \
+};
+
+DEVICE_TASK_TRAIT(Task1Ms, DEVTASK_1MS)
+DEVICE_TASK_TRAIT(Task10Ms, DEVTASK_10MS)
+DEVICE_TASK_TRAIT(Task100Ms, DEVTASK_100MS)
+DEVICE_TASK_TRAIT(Task200Ms, DEVTASK_200MS)
+#undef DEVICE_TASK_TRAIT
+
+template <class T, class Base> struct DeviceTasks
+{
+   static const uint8_t mask = DeviceTaskTask1Ms<T, Base>::mask | DeviceTaskTask10Ms<T, Base>::mask |
+                               DeviceTaskTask100Ms<T, Base>::mask | DeviceTaskTask200Ms<T, Base>::mask;
+};
+
+#endif // DEVICETASKS_H
@@ -0,0 +1,76 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DRIVERS_H
+#define DRIVERS_H
+
+/* Device drivers compiled into this image. The Makefile defines DRV_PROFILE
+ * and one DRV_<name> per driver listed in profiles/$(PROFILE).mk and only
+ * links those objects. Builds that don't go through the Makefile (IDE
+ * project) get every driver.
+ * Categories listed in FIXED also get FIXED_<category> set to the class,
+ * see fixeddevice.h.
+ */
+
+#ifndef DRV_PROFILE
+//Inverters
+#define DRV_LEAFINV
+#define DRV_GS450H
+#define DRV_OPENINV
+#define DRV_OUTLANDERINV
+#define DRV_REAROUTLANDERINV
+#define DRV_T2C
+//Vehicles
+#define DRV_E31
+#define DRV_E39
+#define DRV_E65
+#define DRV_E90
+#define DRV_VAG
+#define DRV_SUBARU
+#define DRV_CLASSIC
+//Chargers
+#define DRV_EXTCHARGER
+#define DRV_AMPERACHARGER
+#define DRV_NISSANPDM
+#define DRV_TESLACHARGER
+#define DRV_OUTLANDERCHARGER
+#define DRV_ELCON
+//Charge interfaces
+#define DRV_CHADEMO
+#define DRV_I3LIM
+#define DRV_CPC
+#define DRV_FOCCCI
+//Heaters
+#define DRV_AMPERAHEATER
+#define DRV_VWHEATER
+#define DRV_OUTLANDERHEATER
+//BMS
+#define DRV_SIMPBMS
+#define DRV_LEAFBMS
+#define DRV_DAISYCHAIN
+#define DRV_KANGOOBMS
+#define DRV_DILITHIUM
+//DC/DC converters
+#define DRV_TESLADCDC
+//Shifters
+#define DRV_F30LEVER
+#define DRV_E65LEVER
+#define DRV_JLRG1
+#define DRV_JLRG2
+#endif
+
+#endif // DRIVERS_H
@@ -43,5 +43,9 @@
    ERROR_MESSAGE_ENTRY(CANTIMEOUT, ERROR_DISPLAY) \
    ERROR_MESSAGE_ENTRY(TMPHSMAX, ERROR_DERATE) \
    ERROR_MESSAGE_ENTRY(TMPMMAX, ERROR_DERATE) \
+   ERROR_MESSAGE_ENTRY(WATCHDOG, ERROR_DISPLAY) \
+   ERROR_MESSAGE_ENTRY(NODRIVER, ERROR_DISPLAY) \
+   ERROR_MESSAGE_ENTRY(PRECHARGELOAD, ERROR_STOP) \
+   ERROR_MESSAGE_ENTRY(PRECHARGEFAST, ERROR_STOP) \
 
 #endif // ERRORMESSAGE_PRJ_H_INCLUDED
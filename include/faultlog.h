@@ -0,0 +1,84 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAULTLOG_H
+#define FAULTLOG_H
+
+/* Fault history. Errors are posted through FaultLog::Post() which forwards
+ * them to ErrorMessage. An error that was quiet for FAULTLOG_REARM x 100ms
+ * creates a new event with a snapshot of opmode, speed, udc and idc and
+ * increments its occurrence counter.
+ * Events are appended to a flash log from the main loop a few half words at
+ * a time. Erasing a full page stalls the CPU so it is only done in MOD_OFF,
+ * until then new events wait in RAM.
+ * Post() runs in task and interrupt context, state shared with Run() is only
+ * touched with interrupts masked. nextSlot and hwWritten belong to Run().
+ */
+
+#include <stdint.h>
+#include "errormessage.h"
+#include "printf.h"
+
+#define FAULTLOG_SIZE     16  //events kept in RAM and reported
+#define FAULTLOG_REARM    10  //100ms ticks an error must be absent before it is logged again
+#define FAULTLOG_HW_PER_RUN 2 //flash half words programmed per main loop pass
+
+class FaultLog
+{
+public:
+    struct Entry
+    {
+        uint32_t uptime;  //RTC counter, seconds since boot
+        uint8_t err;      //ERROR_MESSAGE_NUM, bit 7 set marks a counter carry record in flash
+        uint8_t opmode;
+        uint16_t count;   //occurrences of this error including this one
+        uint16_t clock;   //minutes since Sunday 00:00 from the RTC clock values
+        int16_t speed;
+        int16_t udc;
+        int16_t idc;
+    };
+
+    static void Init();
+    static void Post(ERROR_MESSAGE_NUM err);
+    static void Task100Ms();
+    static void Run(); //call from main loop
+    static bool Clear();
+    static void Print(IPutChar* out);
+    static uint32_t GetRecordSize();
+    static uint32_t ReadRecord(uint32_t offset, uint8_t* data, uint32_t len);
+
+private:
+    static uint32_t PageAddress(int page);
+    static void AddEntry(const Entry& e);
+    static void LoadPage(int page);
+    static bool StartPage(int page, uint32_t seq);
+    static void ProgramEntry(uint32_t addr, const Entry& e);
+
+    static Entry entries[FAULTLOG_SIZE];
+    static uint16_t counts[ERROR_MESSAGE_LAST];
+    static uint8_t active[ERROR_MESSAGE_LAST];
+    static volatile uint8_t head;
+    static volatile uint8_t numEntries;
+    static volatile uint8_t unsaved;
+    static int8_t curPage;
+    static uint32_t curSeq;
+    static uint16_t nextSlot;
+    static uint8_t hwWritten;
+    static volatile bool overrun;
+};
+
+#endif // FAULTLOG_H
@@ -0,0 +1,62 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FIXEDDEVICE_H
+#define FIXEDDEVICE_H
+
+#include "devicetasks.h"
+
+/* Device of a category that is hardwired at build time (FIXED in the build
+ * profile). It stands in for both the DeviceSlot and the selected device
+ * pointer so the Update functions compile unchanged. Calls go through a
+ * final class so the compiler binds them statically and inlines the empty
+ * default tasks away.
+ * The object is constructed once at startup and never rebuilt. Sel is the
+ * value of the selection parameter that picks T, the parameter is set to it
+ * at startup and changes of it are rejected (see ChangeDevice()).
+ */
+
+template <class T> class Fixed final : public T {};
+
+template <class Base, class T, int Sel>
+class FixedDevice
+{
+public:
+   Fixed<T>* operator->() { return &obj; }
+   operator Base*() { return &obj; } //for code outside that works on any device
+
+   /** The selection can't change, assignments of the selected pointer are ignored */
+   FixedDevice& operator=(Base*) { return *this; }
+
+   template <class U> U* Create() { return Get<U>(); }
+   void Clear() {}
+   bool Has(DeviceTask task) const { return DeviceTasks<T, Base>::mask & task; }
+
+   /** @return the object if it is of type T, otherwise 0 */
+   template <class U> U* Get() { return Cast((U*)0); }
+
+   static const bool IsFixed = true;
+   static const int Selection = Sel;
+
+private:
+   T* Cast(T*) { return &obj; }
+   template <class U> U* Cast(U*) { return 0; }
+
+   Fixed<T> obj;
+};
+
+#endif // FIXEDDEVICE_H
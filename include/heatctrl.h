@@ -0,0 +1,80 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HEATCTRL_H
+#define HEATCTRL_H
+
+/* Coolant temperature controller for the cabin heater. A PI controller in
+ * integer fixed point turns the distance to the target temperature into a
+ * power request between 0 and the configured maximum.
+ * - the integrator stops while the output is limited and the error would
+ *   push it further into the limit (conditional integration), so a cold
+ *   start does not overshoot by whatever was accumulated on the way up
+ * - rising power is rate limited to go easy on the HV supply, dropping it
+ *   is not
+ * - with both gains at 0 it requests the maximum power like before
+ * Heaters without a temperature reading use RunOpenLoop(), which requests
+ * the maximum power with the same rate limit.
+ * Energy is accumulated from the requested power.
+ */
+
+#include <stdint.h>
+
+#define HEATCTRL_PERIOD_MS  100 //Run() call interval
+#define HEATCTRL_TSCALE     16  //temperature fraction bits as a factor
+
+class HeatCtrl
+{
+public:
+    /** @param kp proportional gain in W/°C
+     * @param ki integral gain in W/(°C*s)
+     * @param ramp maximum power increase in W/s, 0 for no limit
+     */
+    static void SetParams(int32_t kp, int32_t ki, int32_t ramp);
+    /** Call every HEATCTRL_PERIOD_MS while the heater is enabled
+     * @param temp coolant temperature in °C
+     * @param target target temperature in °C
+     * @param maxPower power limit in W
+     * @return power request in W
+     */
+    static int32_t Run(float temp, float target, int32_t maxPower);
+    /** Call instead of Run() when there is no temperature to regulate on
+     * @param maxPower power limit in W
+     * @return power request in W
+     */
+    static int32_t RunOpenLoop(int32_t maxPower);
+    /** Call while the heater is disabled, restarts from 0 W */
+    static void Reset();
+    static int32_t GetPower() { return power; }
+    /** @return last power request relative to the limit in % */
+    static int32_t GetDuty() { return duty; }
+    /** @return energy requested since boot in Wh */
+    static uint32_t GetEnergy() { return energyWh; }
+
+private:
+    static int32_t Limit(int32_t desired, int32_t maxPower);
+    static int32_t Output(int32_t limited, int32_t maxPower);
+
+    static int32_t kp, ki, ramp;
+    static int32_t integral; //W * HEATCTRL_TSCALE * 1000 / HEATCTRL_PERIOD_MS
+    static int32_t power;
+    static int32_t duty;
+    static uint32_t energyWh;
+    static uint32_t energyRest; //W * HEATCTRL_PERIOD_MS below one Wh
+};
+
+#endif // HEATCTRL_H
@@ -33,12 +33,14 @@ class Heater
 {
 public:
    virtual void DecodeCAN(int, uint32_t*) {};
-   virtual float GetTemperature() { return 0; }
+   virtual float GetTemperature() { return Param::GetFloat(Param::tmpheater); } //coolant temperature in °C
    virtual void SetTargetTemperature(float temp) = 0; //target temperature in °C
    virtual void SetPower(uint16_t power, bool HeatReq) = 0; //Must be called cyclically with power in watts
    virtual void DeInit() {} //called when switching to another heater, similar to a destructor
    virtual void SetCanInterface(CanHardware* c) { can = c; }
    virtual void Task100Ms() {};
+   virtual bool IsIdle() { return true; } //true when no longer drawing from HV
+   virtual bool HasTemperature() { return false; } //true when the driver keeps tmpheater up to date
 
 protected:
    CanHardware* can;
@@ -29,6 +29,7 @@
 #include "my_math.h"
 #include "stm32_can.h"
 #include "params.h"
+#include "contactorseq.h"
 
 class HVCU
 {
@@ -38,7 +39,7 @@ class HVCU
 public:
     static void RegisterCanMessages(CanHardware* can);
     static void DecodeCAN(int id, uint32_t data[2]);
-    static void ControlContactors(int opmode, CanHardware* can);
+    static void ControlContactors(uint8_t contactors, CanHardware* can);
     static void Task100Ms();
 
 private:
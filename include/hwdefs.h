@@ -55,5 +55,6 @@
 #define PARAM_BLKSIZE FLASH_PAGE_SIZE
 #define CAN1_BLKNUM   2
 #define CAN2_BLKNUM   4
+#define FAULTLOG_BLKNUM 8 //uses blocks 8 and 7
 
 #endif // HWDEFS_H_INCLUDED
@@ -23,7 +23,7 @@
 
 #include "digio.h"
 #include "params.h"
-#include "anain.h"
+#include "anafilter.h"
 
 class IOMatrix
 {
@@ -44,16 +44,16 @@ class IOMatrix
       static void AssignFromParams();
       static void AssignFromParamsAnalogue();
       static DigIo* GetPin(pinfuncs f) { return functionToPin[f]; }
-      static AnaIn* GetAnaloguePin(analoguepinfuncs f) { return functionToPinAnalgoue[f]; }
+      static AnaFilter* GetAnaloguePin(analoguepinfuncs f) { return functionToPinAnalgoue[f]; }
 
    private:
       static DigIo* functionToPin[LAST];
       static const int numPins = 14;
       static DigIo* const paramToPin[numPins];
 
-      static AnaIn* functionToPinAnalgoue[LAST_ANAL];
+      static AnaFilter* functionToPinAnalgoue[LAST_ANAL];
       static const int numAnaloguePins = 2;
-      static AnaIn* const paramToPinAnalgue[numAnaloguePins];
+      static AnaFilter* const paramToPinAnalgue[numAnaloguePins];
 };
 
 #endif // IOMATRIX_H
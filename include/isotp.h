@@ -0,0 +1,74 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ISOTP_H
+#define ISOTP_H
+
+/* ISO 15765-2 transport layer, normal addressing. Requests up to
+ * ISOTP_RX_SIZE bytes are reassembled and flow controlled, responses up to
+ * ISOTP_TX_SIZE bytes are sent as single frame or first frame followed by
+ * consecutive frames paced from Task1Ms() according to the testers flow
+ * control (block size and STmin).
+ */
+
+#include <stdint.h>
+#include "canhardware.h"
+
+#define ISOTP_RX_SIZE      64
+#define ISOTP_TX_SIZE      128
+#define ISOTP_TIMEOUT_MS   1000 //N_Bs and N_Cr
+#define ISOTP_PADDING      0x00
+
+class IsoTp
+{
+public:
+    IsoTp();
+    void SetCanInterface(CanHardware* c, uint32_t txId);
+    int HandleRx(uint32_t data[2]); //returns length of a complete message or 0
+    const uint8_t* GetRxData() { return rxBuf; }
+    bool Send(const uint8_t* data, int len);
+    void Task1Ms();
+
+private:
+    enum txstate { TX_IDLE, TX_WAIT_FC, TX_SENDING };
+
+    int Receive(uint32_t data[2]);
+    bool Transmit(const uint8_t* data, int len);
+    void SendFlowControl(uint8_t flowStatus);
+    void SendConsecutiveFrame();
+    void SendFrame(uint8_t* frame);
+
+    CanHardware* can;
+    uint32_t txId;
+    uint8_t rxBuf[ISOTP_RX_SIZE];
+    uint8_t txBuf[ISOTP_TX_SIZE];
+    uint16_t rxLen;
+    uint16_t rxPos;
+    uint8_t rxSn;
+    uint16_t rxTimeout;
+    volatile txstate txState;
+    uint16_t txLen;
+    uint16_t txPos;
+    uint8_t txSn;
+    uint8_t blockSize;
+    uint8_t blockCount;
+    uint8_t stMin;
+    uint8_t stMinCount;
+    uint16_t txTimeout;
+};
+
+#endif // ISOTP_H
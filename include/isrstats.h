@@ -0,0 +1,84 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ISRSTATS_H
+#define ISRSTATS_H
+
+/* Interrupt CPU accounting. Init() copies the vector table to RAM and points
+ * the vectors in ISR_STATS_LIST to a dispatcher that measures the original
+ * handler with the DWT cycle counter. Time spent in nested interrupts is
+ * subtracted from the interrupted handler so loads add up.
+ * Most of these handlers live in libopeninv, this way they are covered
+ * without touching them.
+ */
+
+#include <stdint.h>
+#include <libopencm3/cm3/nvic.h>
+#include "printf.h"
+
+#define ISR_STATS_LIST \
+    ISR_STATS_ENTRY(NVIC_TIM4_IRQ,           "sched") \
+    ISR_STATS_ENTRY(NVIC_USB_LP_CAN_RX0_IRQ, "can1rx0") \
+    ISR_STATS_ENTRY(NVIC_CAN_RX1_IRQ,        "can1rx1") \
+    ISR_STATS_ENTRY(NVIC_USB_HP_CAN_TX_IRQ,  "can1tx") \
+    ISR_STATS_ENTRY(NVIC_CAN2_RX0_IRQ,       "can2rx0") \
+    ISR_STATS_ENTRY(NVIC_CAN2_RX1_IRQ,       "can2rx1") \
+    ISR_STATS_ENTRY(NVIC_CAN2_TX_IRQ,        "can2tx") \
+    ISR_STATS_ENTRY(NVIC_EXTI15_10_IRQ,      "can3") \
+    ISR_STATS_ENTRY(NVIC_RTC_IRQ,            "rtc") \
+    ISR_STATS_ENTRY(NVIC_DMA1_CHANNEL6_IRQ,  "dma1ch6") \
+    ISR_STATS_ENTRY(NVIC_DMA1_CHANNEL7_IRQ,  "dma1ch7") \
+    ISR_STATS_ENTRY(NVIC_USART3_IRQ,         "usart3") \
+    ISR_STATS_ENTRY(NVIC_USART1_IRQ,         "lin") \
+    ISR_STATS_ENTRY(NVIC_TIM6_IRQ,           "linslot")
+
+#define ISR_STATS_ENTRY(irq, name) +1
+enum { ISR_STATS_NUM = 0 ISR_STATS_LIST };
+#undef ISR_STATS_ENTRY
+
+#define ISR_STATS_VECTORS (16 + NVIC_IRQ_COUNT)
+
+class IsrStats
+{
+public:
+    static void Init();
+    static void Update(); //call every 100ms
+    static void Reset();
+    static void Print(IPutChar* out);
+
+private:
+    struct Stats
+    {
+        uint32_t count;
+        uint32_t cycles;      //since last Update()
+        uint32_t maxCycles;
+        uint32_t load;        //permille of the last 100ms
+        uint64_t totalCycles;
+        uint8_t maxNesting;
+    };
+
+    static void Dispatch();
+
+    static Stats stats[ISR_STATS_NUM];
+    static void (*handlers[ISR_STATS_NUM])();
+    static int8_t slot[ISR_STATS_VECTORS];
+    static volatile uint32_t nestedCycles;
+    static volatile uint8_t nesting;
+    static uint32_t vectors[ISR_STATS_VECTORS] __attribute__((aligned(512)));
+};
+
+#endif // ISRSTATS_H
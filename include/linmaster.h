@@ -0,0 +1,95 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LINMASTER_H
+#define LINMASTER_H
+
+/* LIN master on USART1. The schedule is a table of frames that is run over
+ * and over, one frame per slot. TIM6 marks the slots, its interrupt sends the
+ * break. Everything after that happens in the USART1 interrupt, paced by the
+ * transceiver echoing our own bytes: sync, PID, then either our data and
+ * checksum (each echo is compared to what was sent) or the slave response.
+ * A frame that isn't complete when its slot ends counts as an error.
+ * Drivers only exchange data with the frame buffers through Read()/Write(),
+ * no task ever waits for the bus.
+ */
+
+#include <stdint.h>
+#include "printf.h"
+
+#define LIN_BAUDRATE      19200
+#define LIN_MAX_LEN       8
+
+class LinMaster
+{
+public:
+    enum FrameFlags
+    {
+        LIN_PUBLISH = 1, //we send the response, otherwise a slave does
+        LIN_CLASSIC = 2  //LIN 1.x checksum over data only, always used for diagnostic frames
+    };
+
+    struct Frame
+    {
+        Frame(uint8_t i, uint8_t l, uint8_t f, uint8_t s)
+            : id(i), len(l), flags(f), slotMs(s), data(), fresh(false), ok(0), noResponse(0), checksumErrors(0), busErrors(0) {}
+
+        uint8_t id;
+        uint8_t len;
+        uint8_t flags;
+        uint8_t slotMs;  //time until the next frame, must cover the worst case frame time
+        uint8_t data[LIN_MAX_LEN];
+        volatile bool fresh;
+        uint32_t ok;
+        uint32_t noResponse;
+        uint32_t checksumErrors;
+        uint32_t busErrors; //echo mismatch, framing, noise, overrun or incomplete
+    };
+
+    /** Runs the given table from its first frame, configures the hardware on first use
+     * @param frames schedule, must stay valid until replaced, 0 stops the bus */
+    static void SetSchedule(Frame* frames, uint8_t count);
+    /** Sets the data sent in the next slot of a LIN_PUBLISH frame */
+    static void Write(Frame& frame, const uint8_t* data);
+    /** Copies a received response
+     * @return true if a new response arrived since the last call */
+    static bool Read(Frame& frame, uint8_t* data);
+    static void Print(IPutChar* out);
+
+    static void SlotIsr();
+    static void UsartIsr();
+
+private:
+    enum State { IDLE, BREAK, SYNC, PID, TXDATA, RXDATA, DONE, FAILED };
+
+    static void Init();
+    static void Fail();
+    static uint8_t Pid(uint8_t id);
+    static uint8_t Checksum(const Frame& frame, const uint8_t* data);
+
+    static Frame* frames;
+    static uint8_t numFrames;
+    static uint8_t next;
+    static Frame* active;
+    static uint8_t pid;
+    static uint8_t pos;
+    static uint8_t buf[LIN_MAX_LEN + 1];
+    static volatile uint8_t state;
+    static bool initialized;
+};
+
+#endif // LINMASTER_H
@@ -0,0 +1,67 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOWPOWER_H
+#define LOWPOWER_H
+
+/* Stop mode for a parked car. Idle() counts how long the VCU has had nothing
+ * to do, once that reaches SleepDelay the main loop calls Stop(). In stop mode
+ * all clocks except LSI are off, the EXTI lines of the CAN receive pins, the
+ * CAN3 interrupt, the wake inputs and the RTC alarm bring us back.
+ * The RTC normally runs off HSE which stops too, so it is moved to a
+ * calibrated LSI for the duration. The IWDG can't be stopped, we wake up
+ * every LOWPOWER_FEED_S at HSI to feed it and go back to sleep.
+ * The frame that wakes us over CAN is lost, its sender will repeat it.
+ */
+
+#include <stdint.h>
+
+#define LOWPOWER_FEED_S       10
+#define LOWPOWER_IWDG_MS      24000 //covers LOWPOWER_FEED_S with LSI at +/-50%
+#define LOWPOWER_CAL_COUNTS   2000  //LSI periods to calibrate against HSE (50ms)
+
+class LowPower
+{
+public:
+    enum WakeSource { WAKE_NONE, WAKE_CAN1, WAKE_CAN2, WAKE_CAN3, WAKE_T15, WAKE_START, WAKE_HVREQ, WAKE_TIMER };
+
+    /** Call every 100ms, idle is true when nothing would stop us from sleeping */
+    static void Idle(bool idle);
+    /** @return true once we have been idle for SleepDelay */
+    static bool SleepRequested() { return requested; }
+    /** Stops the MCU until a wake up source fires, call from main loop
+     * @param wakeIn wake up after this many seconds, 0 for no time limit
+     * @param hvReq true to wake on HV_req instead of CAN2 which shares its EXTI line
+     * @param can3 true to wake on the CAN3 interrupt, only if the MCP25625 is in use
+     * @return seconds spent in stop mode */
+    static uint32_t Stop(uint32_t wakeIn, bool hvReq, bool can3);
+    /** Call when everything is running again to measure the wake latency */
+    static void Resumed();
+
+private:
+    static WakeSource Sleep(uint32_t alarm, uint32_t lines);
+    static void RtcToLsi();
+    static uint32_t RtcToHse();
+
+    static uint32_t idleTime;
+    static bool requested;
+    static uint32_t wakeCycles;
+    static uint32_t wakeUs;
+    static uint32_t rtcCount;
+};
+
+#endif // LOWPOWER_H
@@ -0,0 +1,58 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MEMSTATS_H
+#define MEMSTATS_H
+
+/* RAM budget. PaintStack() fills the unused RAM between the end of .bss and
+ * the stack pointer with a pattern at boot, Run() finds the lowest address
+ * that was overwritten since, checking a slice of the region per call. There
+ * is only one stack (MSP) which also holds the frames of nested interrupts,
+ * so this is the true worst case including the scheduler tasks running from
+ * tim4_isr.
+ * There is no heap, everything between .bss and the stack is stack reserve.
+ */
+
+#include <stdint.h>
+#include "printf.h"
+
+#define MEMSTATS_PATTERN   0xA5A5A5A5
+#define MEMSTATS_TOP       10 //largest objects printed
+#define MEMSTATS_SLICE     64 //words checked per Run() call
+
+class MemStats
+{
+public:
+    struct Object
+    {
+        const char* name;
+        uint32_t size;
+    };
+
+    static void PaintStack();
+    static void SetObjects(const Object* objects, int count);
+    static void Run(); //call from main loop
+    static void Print(IPutChar* out);
+
+private:
+    static const Object* objects;
+    static int numObjects;
+    static uint32_t* lowWater;
+    static uint32_t* scan; //next word to check
+};
+
+#endif // MEMSTATS_H
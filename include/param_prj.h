@@ -27,7 +27,7 @@
    2. Temporary parameters (id = 0)
    3. Display values
  */
-//Next param id (increase when adding new parameter!): 151
+//Next param id (increase when adding new parameter!): 168
 /*              category     name         unit       min     max     default id */
 #define PARAM_LIST \
     PARAM_ENTRY(CAT_SETUP,     Inverter,     INVMODES, 0,       9,      0,      5  ) \
@@ -54,6 +54,7 @@
     PARAM_ENTRY(CAT_SETUP,     PrechargeTimeout,"sec", 1,       10,     2,      145 ) \
     PARAM_ENTRY(CAT_SETUP,     FuelCap,     "Liters",  1,       1024,    63,     148 ) \
     PARAM_ENTRY(CAT_SETUP,     SafetyOverride, ONOFF,  0,       1,      0,      149 ) \
+    PARAM_ENTRY(CAT_SETUP,     SleepDelay,  "s",       0,       3600,   0,      164 ) \
     PARAM_ENTRY(CAT_THROTTLE,  potmin,      "dig",     0,       4095,   0,      7  ) \
     PARAM_ENTRY(CAT_THROTTLE,  potmax,      "dig",     0,       4095,   4095,   8  ) \
     PARAM_ENTRY(CAT_THROTTLE,  pot2min,     "dig",     0,       4095,   4095,   9  ) \
@@ -88,9 +89,22 @@
     PARAM_ENTRY(CAT_CRUISE,    cruiseramp,  "rpm/100ms",1,      1000,   20,     30 ) \
     PARAM_ENTRY(CAT_CRUISE,    regenlevel,  "",        0,       3,      2,      31 ) \
     PARAM_ENTRY(CAT_CONTACT,   udcsw,       "V",       0,       1000,   330,    32 ) \
+    PARAM_ENTRY(CAT_CONTACT,   PrechargeTol,"V",       0,       100,    10,     160 ) \
+    PARAM_ENTRY(CAT_CONTACT,   PchTauMin,   "ms",      0,       1000,   10,     161 ) \
+    PARAM_ENTRY(CAT_CONTACT,   ShdnIdc,     "A",       0,       50,     5,      162 ) \
+    PARAM_ENTRY(CAT_CONTACT,   ShdnDebounce,"ms",      0,       2000,   200,    163 ) \
     PARAM_ENTRY(CAT_CONTACT,   cruiselight, ONOFF,     0,       1,      0,      33 ) \
     PARAM_ENTRY(CAT_CONTACT,   errlights,   ERRLIGHTS, 0,       255,    0,      34 ) \
     PARAM_ENTRY(CAT_COMM,      CAN3Speed,   CAN3SPD,   0,       2,      0,      77 ) \
+    PARAM_ENTRY(CAT_COMM,      CanMapRate,  CANRATES,  0,       11,     3,      151 ) \
+    PARAM_ENTRY(CAT_COMM,      CanMapId1,   "",        0,       2047,   0,      152 ) \
+    PARAM_ENTRY(CAT_COMM,      CanMapRate1, CANRATES,  0,       11,     3,      153 ) \
+    PARAM_ENTRY(CAT_COMM,      CanMapId2,   "",        0,       2047,   0,      154 ) \
+    PARAM_ENTRY(CAT_COMM,      CanMapRate2, CANRATES,  0,       11,     3,      155 ) \
+    PARAM_ENTRY(CAT_COMM,      CanMapId3,   "",        0,       2047,   0,      156 ) \
+    PARAM_ENTRY(CAT_COMM,      CanMapRate3, CANRATES,  0,       11,     3,      157 ) \
+    PARAM_ENTRY(CAT_COMM,      CanMapId4,   "",        0,       2047,   0,      158 ) \
+    PARAM_ENTRY(CAT_COMM,      CanMapRate4, CANRATES,  0,       11,     3,      159 ) \
     PARAM_ENTRY(CAT_CHARGER,   BattCap,     "kWh",     0.1,     250,    22,     38 ) \
     PARAM_ENTRY(CAT_CHARGER,   Voltspnt,    "V",       0,       1000,   395,    40 ) \
     PARAM_ENTRY(CAT_CHARGER,   Pwrspnt,     "W",       0,       12000,  1500,   41 ) \
@@ -116,6 +130,9 @@
     PARAM_ENTRY(CAT_HEATER,    HeatPwr,     "W",       0,       6500,   0,      59 ) \
     PARAM_ENTRY(CAT_HEATER,    HeatPercnt,  "%",       0,       100,    0,      124 ) \
     PARAM_ENTRY(CAT_HEATER,    HeatTargetTemp,  "°C",  0,       100,    50,     150 ) \
+    PARAM_ENTRY(CAT_HEATER,    HeatKp,      "W/°C",    0,       2000,   300,    165 ) \
+    PARAM_ENTRY(CAT_HEATER,    HeatKi,      "W/°Cs",   0,       100,    1,      166 ) \
+    PARAM_ENTRY(CAT_HEATER,    HeatRamp,    "W/s",     0,       6500,   1000,   167 ) \
     PARAM_ENTRY(CAT_CLOCK,     Set_Day,     DOW,       0,       6,      0,      46 ) \
     PARAM_ENTRY(CAT_CLOCK,     Set_Hour,    "Hours",   0,       23,     0,      47 ) \
     PARAM_ENTRY(CAT_CLOCK,     Set_Min,     "Mins",    0,       59,     0,      48 ) \
@@ -261,8 +278,30 @@
     VALUE_ENTRY(powerheater,   "W",                 2098 ) \
     VALUE_ENTRY(VehLockSt,     ONOFF,               2100 ) \
     VALUE_ENTRY(DriverDoorSt,  DMODES,              2112 ) \
-
-//Next value Id: 2117
+    VALUE_ENTRY(BBState,       BBSTATES,            2118 ) \
+    VALUE_ENTRY(RstCause,      RSTCAUSES,           2119 ) \
+    VALUE_ENTRY(WdTask,        WDTASKS,             2120 ) \
+    VALUE_ENTRY(IsrLoad,       "%",                 2121 ) \
+    VALUE_ENTRY(IsrLoadCan,    "%",                 2122 ) \
+    VALUE_ENTRY(IsrMaxTime,    "us",                2123 ) \
+    VALUE_ENTRY(IsrNest,       "",                  2124 ) \
+    VALUE_ENTRY(StackUsed,     "B",                 2125 ) \
+    VALUE_ENTRY(StackFree,     "B",                 2126 ) \
+    VALUE_ENTRY(RamStatic,     "B",                 2127 ) \
+    VALUE_ENTRY(BootTime,      "ms",                2128 ) \
+    VALUE_ENTRY(FirstCanTime,  "ms",                2129 ) \
+    VALUE_ENTRY(PchTau,        "ms",                2130 ) \
+    VALUE_ENTRY(PchUfinal,     "V",                 2131 ) \
+    VALUE_ENTRY(PchTime,       "ms",                2132 ) \
+    VALUE_ENTRY(CtrStep,       "",                  2133 ) \
+    VALUE_ENTRY(WakeSrc,       WAKESRCS,            2134 ) \
+    VALUE_ENTRY(WakeLatency,   "us",                2135 ) \
+    VALUE_ENTRY(SleepTime,     "s",                 2136 ) \
+    VALUE_ENTRY(PreHeatT,      "M",                 2137 ) \
+    VALUE_ENTRY(HeatDuty,      "%",                 2138 ) \
+    VALUE_ENTRY(HeatEnergy,    "kWh",               2139 ) \
+
+//Next value Id: 2140
 
 //Dead params
 /*
@@ -288,6 +327,9 @@
 #define VEHMODES     "0=BMW_E46, 1=BMW_E6x+, 2=Classic, 3=None, 5=BMW_E39, 6=VAG, 7=Subaru, 8=BMW_E31, 9=BMW_E90"
 #define BMSMODES     "0=Off, 1=SimpBMS, 2=TiDaisychainSingle, 3=TiDaisychainDual, 4=LeafBms, 5=RenaultKangoo33, 6=DilithiumMCU"
 #define OPMODES      "0=Off, 1=Run, 2=Precharge, 3=PchFail, 4=Charge, 5=ShutdownReq"
+#define BBSTATES     "0=Armed, 1=Triggered, 2=Frozen"
+#define RSTCAUSES    "0=Unknown, 1=PowerOn, 2=Pin, 3=Software, 4=Watchdog, 5=WindowWatchdog, 6=LowPower"
+#define WDTASKS      "0=None, 1=1ms, 2=10ms, 3=100ms, 4=200ms"
 #define DOW          "0=Sun, 1=Mon, 2=Tue, 3=Wed, 4=Thu, 5=Fri, 6=Sat"
 #define CHGTYPS      "0=Off, 1=AC, 2=DCFC"
 #define DCDCTYPES    "0=NoDCDC, 1=TeslaG2"
@@ -309,7 +351,9 @@
 #define CHGCTRL      "0=Enable, 1=Disable, 2=Timer"
 #define CHGINT       "0=Unused, 1=i3LIM, 2=Chademo, 3=CPC, 4=Foccci"
 #define CAN3SPD      "0=k33.3, 1=k500, 2=k100"
+#define CANRATES     "0=10ms, 1=20ms, 2=50ms, 3=100ms, 4=200ms, 5=1000ms, 6=Chg10ms, 7=Chg20ms, 8=Chg50ms, 9=Chg100ms, 10=Chg200ms, 11=Chg1000ms"
 #define TRNMODES     "0=Manual, 1=Auto"
+#define WAKESRCS     "0=None, 1=Can1, 2=Can2, 3=Can3, 4=T15, 5=Start, 6=HVreq, 7=Timer"
 #define CAN_DEV      "0=CAN1, 1=CAN2"
 #define CAT_THROTTLE "Throttle"
 #define CAT_POWER    "Power Limit"
@@ -0,0 +1,99 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRECHARGE_H
+#define PRECHARGE_H
+
+/* Precharge curve supervision. While charging through the resistor the bus
+ * voltage follows u = Ufinal - (Ufinal - u0) * e^(-t/tau), so its slope is a
+ * straight line over the voltage: du/dt = (Ufinal - u) / tau. Run() fits that
+ * line to the slope measured over PCH_LAG samples, which gives both tau and
+ * the voltage the curve settles at. From these it
+ * - reports done once the remaining delta to the battery voltage is within
+ *   tolerance. When the battery voltage is unknown the bus has to reach udcsw
+ *   as before, the fit alone can't tell a settled bus from one held down by a
+ *   load.
+ * - fails when the curve settles well below the battery voltage or udcsw
+ *   (load or short on the HV bus), when tau is implausibly short (precharge
+ *   resistor missing or bypassed) or when the predicted completion lies
+ *   beyond the timeout.
+ * A curve too fast to fit at PCH_PERIOD_MS is caught by the first sample.
+ */
+
+#include <stdint.h>
+
+#define PCH_PERIOD_MS     10  //Run() call interval
+#define PCH_LAG           4   //samples the slope is measured over
+#define PCH_MIN_POINTS    8   //slope samples before the fit is trusted
+#define PCH_MIN_SPAN      10  //V the curve must have covered before the fit is trusted
+#define PCH_MIN_COVER     0.25f //... and at least this fraction of the way to the final voltage
+#define PCH_LOAD_RATIO    0.9f //final voltage below this fraction of the battery voltage is a fault
+
+class Precharge
+{
+public:
+    enum State
+    {
+        PCH_IDLE,
+        PCH_RUNNING,
+        PCH_DONE,
+        PCH_FAILSLOW,
+        PCH_FAILLOAD,
+        PCH_FAILFAST
+    };
+
+    /** Call when closing the precharge relay
+     * @param udc bus voltage before closing it
+     */
+    static void Start(float udc);
+    /** Call every PCH_PERIOD_MS while precharging
+     * @param udc bus voltage
+     * @param target battery voltage, 0 if unknown
+     * @param udcsw voltage the bus must reach when target is unknown
+     * @param tol remaining voltage that is considered done
+     * @param timeoutMs give up if not done after this time
+     * @param tauMinMs shortest plausible time constant, 0 disables the check
+     */
+    static State Run(float udc, float target, float udcsw, float tol, uint32_t timeoutMs, uint32_t tauMinMs);
+    static State GetState() { return state; }
+    /** @return true if the fit is trusted and the getters below are valid */
+    static bool HasEstimate();
+    /** @return estimated time constant in ms */
+    static float GetTau() { return tau; }
+    /** @return estimated final voltage */
+    static float GetFinal() { return uFinal; }
+    /** @return time since Start() in ms */
+    static uint32_t GetElapsed() { return elapsed; }
+
+private:
+    static void Fit(float udc);
+
+    static State state;
+    static uint32_t elapsed;
+    static float samples[PCH_LAG];
+    static uint8_t numSamples;
+    static uint8_t pos;
+    static float start;
+    //Running mean and co-moments of voltage and slope
+    static uint16_t n;
+    static float meanU, meanSlope, m2U, cUSlope;
+    static float minU, maxU;
+    static float tau;
+    static float uFinal;
+};
+
+#endif // PRECHARGE_H
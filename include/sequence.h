@@ -0,0 +1,73 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+
+/* Timed step sequences for protocols that need pauses between frames or pin
+ * changes. A sequence is a const table of steps, each calling a function and
+ * then waiting before the next one. RunAll() runs from the 1ms task and
+ * executes at most one step per sequence and call, so nothing ever waits in
+ * a busy loop. Start() may be called from any scheduler task (they don't
+ * preempt each other) or from the main loop for a sequence that is idle.
+ * The longest step of each sequence is measured with the DWT cycle counter.
+ */
+
+#include <stdint.h>
+#include "printf.h"
+
+#define SEQ_PERIOD_MS   1 //RunAll() call interval
+
+#define SEQUENCE_STEPS(steps) steps, sizeof(steps) / sizeof(steps[0])
+
+class Sequence
+{
+public:
+    struct Step
+    {
+        void (*action)(int arg);
+        int arg;
+        uint16_t waitMs; //until the next step, at least SEQ_PERIOD_MS
+    };
+
+    Sequence(const char* name, const Step* steps, uint8_t numSteps);
+    /** Runs the steps from the first one, restarts if already running */
+    void Start();
+    void Stop() { running = false; }
+    bool IsRunning() const { return running; }
+
+    static void RunAll();
+    static void Print(IPutChar* out);
+
+private:
+    void Run();
+
+    const char* name;
+    const Step* steps;
+    uint8_t numSteps;
+    uint8_t pos;
+    uint16_t delay;
+    volatile bool running;
+    bool listed;
+    uint32_t runs;
+    uint32_t maxCycles;
+    Sequence* next;
+
+    static Sequence* first;
+};
+
+#endif // SEQUENCE_H
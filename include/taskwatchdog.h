@@ -0,0 +1,62 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TASKWATCHDOG_H
+#define TASKWATCHDOG_H
+
+/* Task level watchdog. Every scheduler task calls Enter() when it starts and
+ * Leave() when it is done. Feed() runs in the 100ms task and only reloads the
+ * IWDG when every task has run within its period, so a single hung or starved
+ * task resets the controller after TASKWD_TIMEOUT_MS.
+ * The missing tasks and the task that was running are kept in RAM that is not
+ * cleared on reset. Init() evaluates them together with the reset flags and
+ * reports RstCause and WdTask, a watchdog reset is also posted as an error.
+ */
+
+#include <stdint.h>
+
+#define TASKWD_TIMEOUT_MS 1000
+
+class TaskWatchdog
+{
+public:
+    enum task { TASK_NONE, TASK_1MS, TASK_10MS, TASK_100MS, TASK_200MS, TASK_LAST };
+    enum cause { RST_UNKNOWN, RST_POWERON, RST_PIN, RST_SOFTWARE, RST_WATCHDOG, RST_WWDG, RST_LOWPOWER };
+
+    static void Init();
+    static void Enter(task t) { runCount[t]++; noInit.running = t; }
+    static void Leave() { noInit.running = TASK_NONE; }
+    static void Feed();
+
+private:
+    struct NoInitData
+    {
+        uint32_t magic;
+        uint8_t running;
+        uint8_t missing; //bit mask of tasks that had not run at the last Feed()
+        uint16_t resets;
+    };
+
+    static cause GetResetCause();
+
+    static NoInitData noInit;
+    static volatile uint16_t runCount[TASK_LAST];
+    static uint16_t lastCount[TASK_LAST];
+    static uint8_t age[TASK_LAST];
+};
+
+#endif // TASKWATCHDOG_H
@@ -35,6 +35,7 @@ public:
     void Task100Ms() override;
     bool ControlCharge(bool RunCh, bool ACReq) override;
     void SetCanInterface(CanHardware* c) override;
+    bool IsIdle() override;
 };
 
 #endif /* TESLACHARGER_H */
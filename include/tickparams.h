@@ -0,0 +1,75 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TICKPARAMS_H
+#define TICKPARAMS_H
+
+/* Parameters the 10ms task and the functions it calls look at over and over.
+ * Load() reads them once at the start of the tick and the struct is passed
+ * down by reference. Values the tick produces (speed) are written to the
+ * parameter database and updated here so later code sees the new value.
+ * Values that CAN receive updates in the background are sampled at Load(),
+ * a frame that arrives later is picked up by the next tick.
+ */
+
+#include "params.h"
+
+struct TickParams
+{
+   int opmode;
+   int speed;        //motor speed from the last tick until SetSpeed()
+   int dir;
+   int shuntType;
+   int inverter;
+   int reverseMotor;
+   int potmode;
+   bool brake;
+   float udc;
+   float idc;
+   float udclim;
+   s32fp tmphs;      //raw like Param::Get(), the derate code compares them unscaled
+   s32fp tmpm;
+   s32fp tmphsmax;
+   s32fp tmpmmax;
+
+   void Load()
+   {
+      opmode = Param::GetInt(Param::opmode);
+      speed = Param::GetInt(Param::speed);
+      dir = Param::GetInt(Param::dir);
+      shuntType = Param::GetInt(Param::ShuntType);
+      inverter = Param::GetInt(Param::Inverter);
+      reverseMotor = Param::GetInt(Param::reversemotor);
+      potmode = Param::GetInt(Param::potmode);
+      brake = Param::GetBool(Param::din_brake);
+      udc = Param::GetFloat(Param::udc);
+      idc = Param::GetFloat(Param::idc);
+      udclim = Param::GetFloat(Param::udclim);
+      tmphs = Param::Get(Param::tmphs);
+      tmpm = Param::Get(Param::tmpm);
+      tmphsmax = Param::Get(Param::tmphsmax);
+      tmpmmax = Param::Get(Param::tmpmmax);
+   }
+
+   void SetSpeed(int s)
+   {
+      speed = s;
+      Param::SetInt(Param::speed, s);
+   }
+};
+
+#endif // TICKPARAMS_H
@@ -26,6 +26,7 @@
 #include "shifter.h"
 #include "canhardware.h"
 #include "errormessage.h"
+#include "tickparams.h"
 
 namespace utils
 {
@@ -39,9 +40,9 @@ namespace utils
         return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
     }
 
-    float GetUserThrottleCommand(CanHardware*);
-    float ProcessThrottle(int);
-    float ProcessUdc(int);
+    float GetUserThrottleCommand(const TickParams&);
+    float ProcessThrottle(const TickParams&);
+    float ProcessUdc(const TickParams&);
     void CalcSOC();
     void GetDigInputs(CanHardware*);
     void PostErrorIfRunning(ERROR_MESSAGE_NUM);
@@ -32,6 +32,7 @@
 #include "my_math.h"
 #include "stm32_can.h"
 #include "params.h"
+#include "contactorseq.h"
 
 class VWBOX
 {
@@ -44,7 +45,7 @@ class VWBOX
 public:
     static void RegisterCanMessages(CanHardware* can);
     static void DecodeCAN(int id, uint32_t data[2]);
-    static void ControlContactors(int opmode, CanHardware* can);
+    static void ControlContactors(uint8_t contactors, CanHardware* can);
 
     static float Voltage;
     static float Voltage2;
@@ -0,0 +1,4 @@
+# Leaf conversion for fleet vehicles. Nothing can be selected at runtime,
+# each category is hardwired and its calls are bound at compile time.
+DRIVERS =
+FIXED   = LEAFINV CLASSIC NISSANPDM CHADEMO LEAFBMS
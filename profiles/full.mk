@@ -0,0 +1,9 @@
+# Every supported device, this is the default and matches the release image
+DRIVERS = LEAFINV GS450H OPENINV OUTLANDERINV REAROUTLANDERINV T2C \
+          E31 E39 E65 E90 VAG SUBARU CLASSIC \
+          EXTCHARGER AMPERACHARGER NISSANPDM TESLACHARGER OUTLANDERCHARGER ELCON \
+          CHADEMO I3LIM CPC FOCCCI \
+          AMPERAHEATER VWHEATER OUTLANDERHEATER \
+          SIMPBMS LEAFBMS DAISYCHAIN KANGOOBMS DILITHIUM \
+          TESLADCDC \
+          F30LEVER E65LEVER JLRG1 JLRG2
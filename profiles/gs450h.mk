@@ -0,0 +1,7 @@
+# Lexus GS450H/GS300H/Prius transmission in BMW conversions
+DRIVERS = GS450H \
+          E39 E65 E90 CLASSIC \
+          EXTCHARGER TESLACHARGER \
+          I3LIM \
+          SIMPBMS \
+          E65LEVER F30LEVER
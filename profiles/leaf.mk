@@ -0,0 +1,6 @@
+# Nissan Leaf drivetrain with Leaf charger, Leaf battery and CHAdeMO
+DRIVERS = LEAFINV \
+          CLASSIC \
+          NISSANPDM \
+          CHADEMO \
+          SIMPBMS LEAFBMS
@@ -0,0 +1,7 @@
+# Mitsubishi Outlander PHEV drivetrain, charger and heater
+DRIVERS = OUTLANDERINV REAROUTLANDERINV \
+          CLASSIC \
+          OUTLANDERCHARGER \
+          CHADEMO \
+          OUTLANDERHEATER \
+          SIMPBMS
@@ -145,12 +145,6 @@ void BMW_E31::EGSMsg43F(int8_t gear)
     can->Send(0x43F, bytes, 8);
 }
 
-void BMW_E31::Task1Ms()
-{
-
-
-}
-
 
 void BMW_E31::Task10Ms()
 {
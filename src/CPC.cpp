@@ -136,11 +136,6 @@ void CPCClass::handle357(uint32_t data[2])  //Lim data
 }
 
 
-void CPCClass::Task10Ms()
-{
-
-}
-
 
 void CPCClass::Task200Ms()
 {
@@ -173,11 +168,6 @@ void CPCClass::Task200Ms()
     }
 }
 
-void CPCClass::Task100Ms()
-{
-
-}
-
 void CPCClass::Chg_Timers()
 {
     Timer_1Sec--;   //decrement the loop counter
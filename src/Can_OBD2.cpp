@@ -20,6 +20,7 @@
 #include "Can_OBD2.h"
 #include "stm32_can.h"
 #include "params.h"
+#include <libopencm3/stm32/desig.h>
 
 /* Code adapated from https://github.com/skpang/Teensy40_OBDII_simulator */
 
@@ -47,124 +48,248 @@ idc,idc,0x2a07dc,((BIT(A:7) * -256*256*256*256) + (A*256*256*256) + (B*256*256)
 #define MODE2               0x02        //Show freeze frame data
 #define MODE3               0x03        //Show stored Diagnostic Trouble Codes
 #define MODE4               0x04        //Clear Diagnostic Trouble Codes and stored values
-#define MODE42              0x2A
+#define MODE9               0x09        //Request vehicle information
+#define MODE22              0x22        //UDS ReadDataByIdentifier, DID = parameter id
+#define MODE42              0x2A        //Legacy single parameter read, same layout as MODE22
 
 #define PID_SUPPORTED       0x00
 #define MONITOR_STATUS      0x01
 #define ENGINE_COOLANT_TEMP 0x05
 #define ENGINE_RPM          0x0C
 #define VEHICLE_SPEED       0x0D
-#define MAF_SENSOR          0x10
 #define THROTTLE            0x11
-#define O2_VOLTAGE          0x14
-#define HV_BATTERY_VOLTAGE  0x9A
+#define CONTROL_MODULE_VOLT 0x42
 #define FUEL_TYPE           0x51
+#define HYBRID_BATTERY_LIFE 0x5B
 
-#define MODE1_RESPONSE      0x41
-#define MODE3_RESPONSE      0x43
-#define MODE4_RESPONSE      0x44
-#define MODE42_RESPONSE     0x6A
+#define VIN                 0x02
+#define ECU_NAME            0x0A
+
+#define RESPONSE_OFFSET     0x40
+#define NEGATIVE_RESPONSE   0x7F
+#define NRC_OUT_OF_RANGE    0x31
 #define PID_REQUEST         0x7DF
+#define PID_REQUEST_PHYS    0x7E0
 #define PID_REPLY           0x7E8
 
+#define FUEL_TYPE_ELECTRIC  8
+
+/* Mode 1 PIDs, value = param * gain + offset sent as unsigned big endian with len bytes.
+   Entries without a parameter always send offset. The supported PID bitmaps are
+   generated from this table, so adding a line here is all it takes. */
+static const struct
+{
+  uint8_t pid;
+  Param::PARAM_NUM param;
+  uint8_t len;
+  float gain;
+  float offset;
+} mode1Pids[] =
+{
+  { MONITOR_STATUS,      Param::PARAM_INVALID, 4, 0,    0x0007FF00 },
+  { ENGINE_COOLANT_TEMP, Param::tmpm,          1, 1,    40 },
+  { ENGINE_RPM,          Param::speed,         2, 4,    0 },
+  { VEHICLE_SPEED,       Param::Veh_Speed,     1, 1,    0 },
+  { THROTTLE,            Param::potnom,        1, 2.55, 0 },
+  { CONTROL_MODULE_VOLT, Param::U12V,          2, 1000, 0 },
+  { FUEL_TYPE,           Param::PARAM_INVALID, 1, 0,    FUEL_TYPE_ELECTRIC },
+  { HYBRID_BATTERY_LIFE, Param::SOC,           1, 2.55, 0 },
+};
+
+#define NUM_MODE1_PIDS (sizeof(mode1Pids) / sizeof(mode1Pids[0]))
 
 void Can_OBD2::SetCanInterface(CanHardware *c)
 {
   can = c;
+  isotp.SetCanInterface(c, PID_REPLY);
 
-   can->RegisterUserMessage(0x7DF);
+  can->RegisterUserMessage(PID_REQUEST);
+  can->RegisterUserMessage(PID_REQUEST_PHYS); //physical requests and flow control
 }
 
 void Can_OBD2::DecodeCAN(int id, uint32_t data[2])
 {
-  uint8_t *bytes = (uint8_t *)data; // arrgghhh this converts the two 32bit array into bytes. See comments are useful:)
-  uint8_t response[8];
-  uint16_t speed;
+  if (id == PID_REQUEST || id == PID_REQUEST_PHYS)
+  {
+    int len = isotp.HandleRx(data);
+
+    if (len > 0)
+      ProcessRequest(isotp.GetRxData(), len);
+  }
+}
+
+void Can_OBD2::ProcessRequest(const uint8_t *request, int len)
+{
+  uint8_t response[ISOTP_TX_SIZE];
+  int respLen = 0;
+
+  switch (request[0])
+  {
+  case MODE1:
+    respLen = Mode1Response(request, len, response);
+    break;
+  case MODE3:
+    response[0] = MODE3 + RESPONSE_OFFSET;
+    response[1] = 0x00; //no stored DTCs
+    respLen = 2;
+    break;
+  case MODE4:
+    response[0] = MODE4 + RESPONSE_OFFSET;
+    respLen = 1;
+    break;
+  case MODE9:
+    if (len > 1)
+      respLen = Mode9Response(request[1], response);
+    break;
+  case MODE22:
+  case MODE42:
+    respLen = ReadDataByIdResponse(request, len, response);
+    break;
+  }
+
+  if (respLen > 0)
+    isotp.Send(response, respLen);
+}
+
+/* A mode 1 request may carry up to 6 PIDs, all of them are answered in one response */
+int Can_OBD2::Mode1Response(const uint8_t *request, int len, uint8_t *response)
+{
+  int pos = 1;
+
+  response[0] = MODE1 + RESPONSE_OFFSET;
+
+  for (int i = 1; i < len && i <= 6; i++)
+  {
+    int pidLen = GetMode1Pid(request[i], &response[pos + 1]);
+
+    if (pidLen > 0)
+    {
+      response[pos] = request[i];
+      pos += pidLen + 1;
+    }
+  }
+
+  return pos > 1 ? pos : 0; //no response at all when no PID is supported
+}
+
+int Can_OBD2::GetMode1Pid(uint8_t pid, uint8_t *response)
+{
+  if ((pid & 0x1F) == 0) //PID_SUPPORTED, 0x20, 0x40...
+  {
+    uint32_t supported = 0;
 
-  if (id == 0x7DF)
-  { // PID Request
-    switch (bytes[1])
+    for (uint32_t i = 0; i < NUM_MODE1_PIDS; i++)
     {
-    case MODE3:
-      response[0] = 0x02;
-      response[1] = MODE3_RESPONSE;
-      response[2] = 0x00;
-      can->Send(PID_REPLY, response, 8);
-      break;
-    case MODE4:
-      response[0] = 0x00;
-      response[1] = MODE4_RESPONSE;
-      can->Send(PID_REPLY, response, 8);
-      break;
-    case MODE1:
-      response[1] = MODE1_RESPONSE;
-      switch (bytes[2])
-      {
-      case PID_SUPPORTED:
-        response[0] = 0x06;
-        response[2] = PID_SUPPORTED;
-        response[3] = 0x08;
-        response[4] = 0x18;
-        response[5] = 0x00;
-        response[6] = 0x00;
-        response[7] = 0x00;
-        can->Send(PID_REPLY, response, 8);
-        break;
-      case MONITOR_STATUS:
-        response[0] = 0x05;
-        response[2] = MONITOR_STATUS;
-        response[3] = 0x00;
-        response[4] = 0x07;
-        response[5] = 0xFF;
-        can->Send(PID_REPLY, response, 8);
-        break;
-      /* Mapped a few very obvious params to stock PIDs, there coudl certainly be more */
-      case ENGINE_RPM:
-        response[0] = 0x04;
-        response[2] = ENGINE_RPM;
-        speed = Param::GetInt(Param::speed);
-        response[3] = (speed >> 8) & 0xFF;
-        response[4] = (speed) & 0xFF;
-        can->Send(PID_REPLY, response, 8);
-        break;
-      case ENGINE_COOLANT_TEMP:
-        response[0] = 0x03;
-        response[2] = ENGINE_COOLANT_TEMP;
-        response[3] = (Param::GetInt(Param::tmpm) + 40) & 0xFF;
-        can->Send(PID_REPLY, response, 8);
-        break;
-      case VEHICLE_SPEED:
-        response[0] = 0x03;
-        response[2] = VEHICLE_SPEED;
-        response[3] = (Param::GetInt(Param::Veh_Speed)) & 0xFF;
-        can->Send(PID_REPLY, response, 8);
-        break;
-      }
-      break;
-    case MODE42:
-      response[0] = 7;
-      uint16_t pid = bytes[2] * 256 + bytes[3];
-      if (Param::NumFromId(pid) != Param::PARAM_INVALID)
-      {
-        response[1] = MODE42_RESPONSE;
-        int32_t val = Param::Get(Param::NumFromId(pid));
-        response[2] = bytes[2];
-        response[3] = bytes[3];
-        response[4] = (val >> 24) & 0xFF;
-        response[5] = (val >> 16) & 0xFF;
-        response[6] = (val >> 8) & 0xFF;
-        response[7] = val & 0xFF;
-        can->Send(PID_REPLY, response, 8);
-      }
-      else
-      {
-        response[0] = 3;
-        response[1] = 0x7F;
-        response[2] = 0x22;
-        response[3] = 0x31;
-        can->Send(PID_REPLY, response, 8);
-      }
-      break;
+      if (mode1Pids[i].pid > pid && mode1Pids[i].pid <= (pid + 0x20))
+        supported |= 1UL << (32 - (mode1Pids[i].pid - pid));
+      else if (mode1Pids[i].pid > (pid + 0x20))
+        supported |= 1; //next range is supported
     }
+
+    if (pid != PID_SUPPORTED && supported == 0) return 0;
+
+    response[0] = supported >> 24;
+    response[1] = supported >> 16;
+    response[2] = supported >> 8;
+    response[3] = supported;
+    return 4;
+  }
+
+  for (uint32_t i = 0; i < NUM_MODE1_PIDS; i++)
+  {
+    if (mode1Pids[i].pid == pid)
+    {
+      float val = mode1Pids[i].offset;
+      uint32_t max = mode1Pids[i].len < 4 ? (1UL << (8 * mode1Pids[i].len)) - 1 : 0xFFFFFFFF;
+      uint32_t raw;
+
+      if (mode1Pids[i].param != Param::PARAM_INVALID)
+        val += Param::GetFloat(mode1Pids[i].param) * mode1Pids[i].gain;
+
+      raw = val < 0 ? 0 : (val > max ? max : (uint32_t)val);
+
+      for (int b = 0; b < mode1Pids[i].len; b++)
+        response[b] = raw >> (8 * (mode1Pids[i].len - b - 1));
+
+      return mode1Pids[i].len;
+    }
+  }
+  return 0;
+}
+
+int Can_OBD2::Mode9Response(uint8_t pid, uint8_t *response)
+{
+  static const char ecuName[20] = { 'V', 'C', 'U', 0, '-', 'Z', 'o', 'm', 'b', 'i', 'e', 'V', 'e', 'r', 't', 'e', 'r', 0, 0, 0 };
+  static const char hex[] = "0123456789ABCDEF";
+
+  response[0] = MODE9 + RESPONSE_OFFSET;
+  response[1] = pid;
+
+  switch (pid)
+  {
+  case PID_SUPPORTED:
+    response[2] = 0x40; //VIN
+    response[3] = 0x40; //ECU name
+    response[4] = 0x00;
+    response[5] = 0x00;
+    return 6;
+  case VIN:
+  {
+    //There is no VIN parameter, the MCU unique id makes a stable per unit identifier
+    uint32_t id0 = DESIG_UNIQUE_ID0;
+    uint32_t id1 = DESIG_UNIQUE_ID1;
+
+    response[2] = 1; //number of data items
+    response[3] = 'Z';
+    response[4] = 'V';
+    response[5] = 'C';
+    response[6] = 'U';
+    for (int i = 0; i < 5; i++)
+      response[7 + i] = hex[(id1 >> (16 - 4 * i)) & 0xF];
+    for (int i = 0; i < 8; i++)
+      response[12 + i] = hex[(id0 >> (28 - 4 * i)) & 0xF];
+    return 20;
+  }
+  case ECU_NAME:
+    response[2] = 1;
+    for (int i = 0; i < 20; i++)
+      response[3 + i] = ecuName[i];
+    return 23;
+  }
+  return 0;
+}
+
+/* Every parameter and value can be read by its id, several ids per request.
+   Each returns id high, id low and the raw fixed point value as big endian int32 */
+int Can_OBD2::ReadDataByIdResponse(const uint8_t *request, int len, uint8_t *response)
+{
+  int pos = 1;
+
+  response[0] = request[0] + RESPONSE_OFFSET;
+
+  for (int i = 1; (i + 1) < len && (pos + 6) <= ISOTP_TX_SIZE; i += 2)
+  {
+    uint16_t did = request[i] * 256 + request[i + 1];
+    Param::PARAM_NUM param = Param::NumFromId(did);
+
+    if (param != Param::PARAM_INVALID)
+    {
+      int32_t val = Param::Get(param);
+      response[pos++] = request[i];
+      response[pos++] = request[i + 1];
+      response[pos++] = (val >> 24) & 0xFF;
+      response[pos++] = (val >> 16) & 0xFF;
+      response[pos++] = (val >> 8) & 0xFF;
+      response[pos++] = val & 0xFF;
+    }
+  }
+
+  if (pos == 1) //none of the ids exist
+  {
+    response[0] = NEGATIVE_RESPONSE;
+    response[1] = request[0];
+    response[2] = NRC_OUT_OF_RANGE;
+    pos = 3;
   }
+  return pos;
 }
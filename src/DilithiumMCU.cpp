@@ -18,7 +18,7 @@
  */
 
 #include "DilithiumMCU.h"
-#include "errormessage.h"
+#include "faultlog.h"
 
 /*
  * This module receives messages from DilithiumMCU and updates the
@@ -149,7 +149,7 @@ void DilithiumMCU::Task100Ms()
    }
    else
    {
-      ErrorMessage::Post(ERR_BMS_COMM);
+      FaultLog::Post(ERR_BMS_COMM);
 
       Param::SetFloat(Param::BMS_Vmin, 0);
       Param::SetFloat(Param::BMS_Vmax, 0);
@@ -174,12 +174,12 @@ void DilithiumMCU::Task100Ms()
 
       if (BMS_Isolation < Param::GetFloat(Param::BMS_IsoLimit))
       {
-         ErrorMessage::Post(ERR_ISOLATION);
+         FaultLog::Post(ERR_ISOLATION);
       }
    }
    else
    {
-      //ErrorMessage::Post(ERR_GFM_COMM); FIXME, no error for now
+      //FaultLog::Post(ERR_GFM_COMM); FIXME, no error for now
       
       Param::SetFloat(Param::BMS_IsoMeas, 0); // isolation in Ohm/v
       Param::SetFloat(Param::BMS_Isolation, 0); // total isolation in Ohm
@@ -66,11 +66,6 @@ void E65_Lever::DecodeCAN(int id, uint32_t* data)
 }
 
 
-void E65_Lever::Task10Ms()
-{
-
-}
-
 
 void E65_Lever::Task100Ms()
 {
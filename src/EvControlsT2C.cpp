@@ -18,7 +18,7 @@
  */
 
 #include "EvControlsT2C.h"
-#include "errormessage.h"
+#include "faultlog.h"
 #include "my_math.h"
 #include "params.h"
 
@@ -173,10 +173,6 @@ void EvControlsT2C::SetTorque(float torquePercent)
     can->Send(0x201, bytes, 3);       // id, array, length
 }
 
-void EvControlsT2C::Task10Ms()
-{
-}
-
 void EvControlsT2C::Task100Ms()
 {
     static int counter = 0;
@@ -185,7 +181,7 @@ void EvControlsT2C::Task100Ms()
    if (timeoutCounterInv > 0) timeoutCounterInv--;
    if (timeoutCounterInv < 1)
    {
-      ErrorMessage::Post(ERR_INV_COMM);
+      FaultLog::Post(ERR_INV_COMM);
       //Set important variables to 0 when timeout
       voltage = 0;
       Param::SetFloat(Param::INVudc, voltage);
@@ -340,10 +340,6 @@ void F30_Lever::sendcan()
     can->Send(0x202, bytes, 2);
 }
 
-void F30_Lever::Task10Ms()
-{
-}
-
 void F30_Lever::Task100Ms()
 {
     if (!Param::GetInt(Param::T15Stat))
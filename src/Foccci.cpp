@@ -250,11 +250,6 @@ void FoccciClass::Task10Ms()
 }
 
 
-void FoccciClass::Task200Ms()
-{
-
-}
-
 void FoccciClass::Task100Ms()
 {
     if(ChargePort_ReadyDCFC)
@@ -22,7 +22,7 @@
 #include "hwinit.h"
 #include "temp_meas.h"
 #include <libopencm3/stm32/timer.h>
-#include "anain.h"
+#include "anafilter.h"
 #include "my_math.h"
 #include "utils.h"
 
@@ -233,8 +233,8 @@ void GS450HClass::SetTorque(float torquePercent)
 
 float GS450HClass::GetMotorTemperature()
 {
-    int tmpmg1 = AnaIn::MG1_Temp.Get();//in the gs450h case we must read the analog temp values from sensors in the gearbox
-    int tmpmg2 = AnaIn::MG2_Temp.Get();
+    int tmpmg1 = AnaFilter::MG1_Temp.Get();//in the gs450h case we must read the analog temp values from sensors in the gearbox
+    int tmpmg2 = AnaFilter::MG2_Temp.Get();
 
     float t1 = (tmpmg1*(-0.02058758))+56.56512898;//Trying a best fit line approach.
     float t2 = (tmpmg2*(-0.02058758))+56.56512898;;
@@ -0,0 +1,134 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * Copyright (C) 2021-2022  Jamie Jones <jamie@jamie-jones.co.uk>
+ * 	                        Damien Maguire <info@evbmw.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Preheater.h"
+
+Preheater::Preheater()
+{
+   PreHeatSet = 0;
+   RunPreHeat = false;
+   PreheatTicks = 0;
+   PreHeatHrs_tmp = 0;
+   PreHeatMins_tmp = 0;
+   PreHeatDur_tmp = 0;
+   initbyPreHeat = false;
+   heatDemand = false;
+   heaterTemp = false;
+}
+
+//Works like the charge timer: start at the set time, then count down the duration in 200ms ticks
+void Preheater::Task200Ms(int opmode, unsigned hours, unsigned minutes, bool hasTemperature)
+{
+   heaterTemp = hasTemperature;
+
+   if (PreHeatSet == 2 && HeaterUsable())
+   {
+      if (!RunPreHeat && opmode != MOD_RUN && PreHeatDur_tmp != 0 &&
+          PreHeatHrs_tmp == hours && PreHeatMins_tmp == minutes)
+      {
+         RunPreHeat = true;
+         PreheatTicks = PreHeatDur_tmp * 300;
+      }
+
+      if (RunPreHeat)
+      {
+         if (PreheatTicks != 0) PreheatTicks--;
+         if (PreheatTicks == 0) RunPreHeat = false;
+      }
+   }
+   else
+   {
+      RunPreHeat = false;
+   }
+
+   Param::SetInt(Param::PreHeatT, RunPreHeat ? (PreheatTicks + 299) / 300 : 0); //minutes left
+}
+
+//Heat demand against the target temperature, the heater may not regulate itself
+void Preheater::Ms10Task()
+{
+   float temp = Param::GetFloat(Param::tmpheater);
+   float target = Param::GetFloat(Param::HeatTargetTemp);
+
+   if (!RunPreHeat || !heaterTemp)
+      heatDemand = false;
+   else if (temp >= target)
+      heatDemand = false;
+   else if (temp < target - PREHEAT_HYST)
+      heatDemand = true;
+}
+
+//Ends a running preheat, e.g. when the car is started
+void Preheater::Stop()
+{
+   RunPreHeat = false;
+   PreheatTicks = 0;
+   heatDemand = false;
+   Param::SetInt(Param::PreHeatT, 0);
+}
+
+//Timer settings only take effect when no preheat is running
+void Preheater::ParamsChange()
+{
+   if (!RunPreHeat)
+   {
+      PreHeatHrs_tmp = Param::GetInt(Param::Pre_Hrs);
+      PreHeatMins_tmp = Param::GetInt(Param::Pre_Min);
+      PreHeatDur_tmp = Param::GetInt(Param::Pre_Dur);
+   }
+   PreHeatSet = Param::GetInt(Param::Control);
+}
+
+void Preheater::SetInitByPreHeat(bool initbyPH)
+{
+   initbyPreHeat = initbyPH;
+}
+
+bool Preheater::GetRunPreHeat()
+{
+   return RunPreHeat;
+}
+
+bool Preheater::GetInitByPreHeat()
+{
+   return initbyPreHeat;
+}
+
+bool Preheater::GetHeatDemand()
+{
+   return heatDemand;
+}
+
+//A heater is selected and reports the temperature the demand depends on
+bool Preheater::HeaterUsable()
+{
+   return heaterTemp && Param::GetInt(Param::Heater) != HeatType::Noheater;
+}
+
+uint32_t Preheater::GetStartDelay(unsigned hours, unsigned minutes, unsigned seconds)
+{
+   if (PreHeatSet != 2 || PreHeatDur_tmp == 0 || !HeaterUsable()) return 0;
+
+   uint32_t now = (hours * 60 + minutes) * 60 + seconds;
+   uint32_t start = (PreHeatHrs_tmp * 60 + PreHeatMins_tmp) * 60;
+   uint32_t delay = (start + 86400 - now) % 86400;
+
+   return delay ? delay : 86400;
+}
@@ -36,6 +36,7 @@ void TeslaDCDC::DecodeCAN(int id, uint8_t *data)
    {
        Param::SetFloat(Param::U12V,data[5]*0.1);//Display 12v system voltage as read from the dcdc
        Param::SetFloat(Param::I12V,data[4]);//Display 12v system current as read from the dcdc
+       current = data[4];
        Param::SetFloat(Param::ChgTemp,(data[2]*0.5)-40);//Display dcdc coolant temp
 
    }
@@ -68,3 +69,9 @@ uint8_t bytes[8];
 
 }
 
+// No longer enabled and the converter reports no output current
+bool TeslaDCDC::IsIdle()
+{
+   int opmode = Param::GetInt(Param::opmode);
+   return opmode != MOD_RUN && opmode != MOD_CHARGE && current == 0;
+}
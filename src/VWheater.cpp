@@ -29,56 +29,57 @@
 
  #include <VWheater.h>
 
- static uint8_t processedPower=0;
- static uint8_t TenCount=0;
+ #define SLOT_MS 50
 
+ static uint8_t reportedPower=0;
 
- void vwHeater::SetLinInterface(LinBus* l)
+ static LinMaster::Frame schedule[] =
+ {
+    LinMaster::Frame(48, 8, 0, SLOT_MS), //0x30 status
+    LinMaster::Frame(28, 4, LinMaster::LIN_PUBLISH, SLOT_MS) //0x1C command
+ };
+
+
+ void vwHeater::SetLinInterface()
  {
-    lin = l;
     DigIo::lin_wake.Clear();//Not used on TJA1027
     DigIo::lin_nslp.Set();//Wakes the device
+    LinMaster::SetSchedule(schedule, sizeof(schedule) / sizeof(schedule[0]));
     //Johannes for president!
 
  }
 
+ void vwHeater::DeInit()
+ {
+    LinMaster::SetSchedule(0, 0);
+    DigIo::lin_nslp.Clear();
+ }
+
  void vwHeater::SetPower(uint16_t power, bool HeatReq)
 {
-    TenCount++;
-    if(TenCount==5)//slow down to 50ms as this is called in 10ms task.
-    {
-    TenCount=0;
-    HeatReq=HeatReq;
-   //going to ignore heatreq just for test.
+   uint8_t data[8];
 
-   if(power>=255) power = 255;//Constrain power to max for VW heater.
-   processedPower=power;//10;
-
-   static bool read = true;
+   power=power;
+   HeatReq=HeatReq;
+   //going to ignore heatreq just for test.
 
-   if (lin->HasReceived(48, 8))//0x30 hex address
+   if (LinMaster::Read(schedule[0], data))
    {
-      uint8_t* data = lin->GetReceivedBytes();
-
       Param::SetFloat(Param::tmpheater, data[6]-47);//Looks like the temp val has an offset prob for neg vals. Need to get it more accurate
       Param::SetFloat(Param::udcheater, data[4]/10);//0x8D = 141 dec /10 =14.1V ? 12v system voltage.
       Param::SetFloat(Param::powerheater,data[0]*80);//actual power used by heater. again, needs some more experiments to get more accurate
+      reportedPower = data[0];
    }
 
-   if (read)
-   {
-      lin->Request(48, 0, 0);//0x30 hex address
-   }
-   else
-   {
-      uint8_t lindata[4];
-      lindata[0] = Param::GetInt(Param::HeatPercnt);//VW heater uses a % setting as opposed to a set power val. Regulates its temps to this.
-      lindata[1] = 1;//Always on for test. Can use heatreq here.
-      lindata[2] = 0;
-      lindata[3] = 0;
-      lin->Request(28, lindata, sizeof(lindata));//0x1C hex address
-   }
+   data[0] = Param::GetInt(Param::HeatPercnt);//VW heater uses a % setting as opposed to a set power val. Regulates its temps to this.
+   data[1] = 1;//Always on for test. Can use heatreq here.
+   data[2] = 0;
+   data[3] = 0;
+   LinMaster::Write(schedule[1], data);
+}
 
-   read = !read;
-   }
+//Always commanded on for now, so go by what the heater reports
+bool vwHeater::IsIdle()
+{
+   return reportedPower == 0;
 }
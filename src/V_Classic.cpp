@@ -49,16 +49,6 @@ void V_Classic::SetTemperatureGauge(float temp)
     dc = dc;
 }
 
-void V_Classic::Task1Ms()
-{
-
-}
-
-
-void V_Classic::Task10Ms()
-{
-
-}
 
 
 void V_Classic::Task100Ms()
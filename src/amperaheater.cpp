@@ -82,10 +82,24 @@ return tmp;
 #include "CANSPI.h"
 #include "digio.h"
 #include "utils.h"
+#include "sequence.h"
 
 static uCAN_MSG txMessage_Ampera;
 static uint8_t ampera_msg_cnt=0;
 
+static void SetHvMode(int);
+static void SendWakeupFrame(int);
+static void SetNormalMode(int);
+
+static const Sequence::Step wakeupSteps[] =
+{
+   { SetHvMode, 0, SEQ_PERIOD_MS },
+   { SendWakeupFrame, 0, SEQ_PERIOD_MS },
+   { SetNormalMode, 0, SEQ_PERIOD_MS }
+};
+
+static Sequence wakeupSeq("amperawake", SEQUENCE_STEPS(wakeupSteps));
+
 AmperaHeater::AmperaHeater()
 {
    //ctor
@@ -93,7 +107,8 @@ AmperaHeater::AmperaHeater()
 
 void AmperaHeater::SetPower(uint16_t power, bool heatReq)
 {
-   if(power==0) isAwake = false;//if we are disabled do nothing but set isAwake to false for next wakeup ...
+   //Stay awake while heat is requested, the controller may ask for 0W at the target temperature
+   if(!heatReq) isAwake = false;//if we are disabled do nothing but set isAwake to false for next wakeup ...
    else//otherwise do everything
    {
 
@@ -104,6 +119,9 @@ void AmperaHeater::SetPower(uint16_t power, bool heatReq)
       isAwake = true;
    }
 
+   //The messages below switch the transceiver back to normal mode
+   if (wakeupSeq.IsRunning()) return;
+
    switch(ampera_msg_cnt)
    {
    case 0:
@@ -148,8 +166,7 @@ void AmperaHeater::SetPower(uint16_t power, bool heatReq)
       txMessage_Ampera.frame.dlc = 5;
       txMessage_Ampera.frame.data0 = 0x02;
       // map requested power to valid range of heater (0 - 0x85)
-      if(heatReq) txMessage_Ampera.frame.data1 = utils::change(power, 0, 6500, 0, 133);//transmitt heater power command when requested
-      if(!heatReq) txMessage_Ampera.frame.data1 = 0x00;//else send 0 power request.
+      txMessage_Ampera.frame.data1 = utils::change(power, 0, 6500, 0, 133);//transmitt heater power command, may be 0
       txMessage_Ampera.frame.data2 = 0x00;
       txMessage_Ampera.frame.data3 = 0x00;
       txMessage_Ampera.frame.data4 = 0x00;
@@ -223,23 +240,23 @@ void AmperaHeater::SetPower(uint16_t power, bool heatReq)
 }
 }
 
-#define FLASH_DELAY 9000
-static void delay(void)
-{
-   int i;
-   for (i = 0; i < FLASH_DELAY; i++)       /* Wait a bit. */
-      __asm__("nop");
-}
-
 /*
  * Wake up all SW-CAN devices by switching the transceiver to HV mode and
  * sending the command 0x100 and switching the HV mode off again.
  */
 void AmperaHeater::SendWakeup()
+{
+   wakeupSeq.Start();
+}
+
+static void SetHvMode(int)
 {
    DigIo::sw_mode0.Clear();
    DigIo::sw_mode1.Set();  // set HV mode
-   delay();
+}
+
+static void SendWakeupFrame(int)
+{
    // 0x100, False, 0, 00,00,00,00,00,00,00,00
    txMessage_Ampera.frame.idType = dSTANDARD_CAN_MSG_ID_2_0B;
    txMessage_Ampera.frame.id = 0x100;
@@ -253,8 +270,10 @@ void AmperaHeater::SendWakeup()
    txMessage_Ampera.frame.data6 = 0x00;
    txMessage_Ampera.frame.data7 = 0x00;
    CANSPI_Transmit(&txMessage_Ampera);
-   //may need delay here
-   delay();
+}
+
+static void SetNormalMode(int)
+{
    DigIo::sw_mode0.Set();
    DigIo::sw_mode1.Set();  // set normal mode
 }
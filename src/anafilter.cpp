@@ -0,0 +1,77 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "anafilter.h"
+
+AnaFilter::AnaFilter(uint8_t p, uint8_t m, uint8_t d)
+    : periodMs(p > 0 ? p : 1), medianLen(m < 1 ? 1 : (m > ANAFILTER_MAX_MEDIAN ? ANAFILTER_MAX_MEDIAN : m)),
+      decimation(d > 0 ? d : 1), tick(0), window(), filled(0), pos(0), sum(0), summed(0), valid(false), value(0), time(0)
+{
+}
+
+bool AnaFilter::Due()
+{
+    if (++tick < periodMs / ANAFILTER_PERIOD_MS) return false;
+
+    tick = 0;
+    return true;
+}
+
+void AnaFilter::Sample(uint16_t raw, uint32_t t)
+{
+    window[pos] = raw;
+    pos = (pos + 1) % medianLen;
+    if (filled < medianLen) filled++;
+
+    uint16_t median = Median();
+
+    if (!valid)
+    {
+        value = median;
+        time = t;
+        valid = true;
+        return;
+    }
+
+    sum += median;
+    summed++;
+
+    if (summed >= decimation)
+    {
+        value = (sum + decimation / 2) / decimation;
+        time = t;
+        sum = 0;
+        summed = 0;
+    }
+}
+
+uint16_t AnaFilter::Median()
+{
+    uint16_t sorted[ANAFILTER_MAX_MEDIAN];
+
+    //Insertion sort, at most 5 values
+    for (int i = 0; i < filled; i++)
+    {
+        int j = i;
+
+        for (; j > 0 && sorted[j - 1] > window[i]; j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = window[i];
+    }
+
+    return sorted[filled / 2];
+}
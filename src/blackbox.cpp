@@ -0,0 +1,230 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "blackbox.h"
+#include "my_math.h"
+#include <libopencm3/stm32/rtc.h>
+
+//Userspace SDO commands, same encoding as CanSdo uses
+#define BB_SDO_WRITE         0x20
+#define BB_SDO_READ          0x40
+#define BB_SDO_ABORT         0x80
+#define BB_SDO_WRITE_REPLY   0x60
+#define BB_SDO_READ_REPLY    0x43
+#define BB_SDO_ERR_INVIDX    0x06020000
+#define BB_SDO_ERR_RANGE     0x06090030
+
+#define BB_SIGNAL_ENTRY(name, scale) Param::name,
+static const Param::PARAM_NUM signalParams[] = { BB_SIGNAL_LIST };
+#undef BB_SIGNAL_ENTRY
+
+#define BB_SIGNAL_ENTRY(name, scale) scale,
+static const int16_t signalScales[] = { BB_SIGNAL_LIST };
+#undef BB_SIGNAL_ENTRY
+
+#define BB_SIGNAL_ENTRY(name, scale) #name,
+static const char* signalNames[] = { BB_SIGNAL_LIST };
+#undef BB_SIGNAL_ENTRY
+
+int16_t BlackBox::buffer[BB_SAMPLES][SIG_LAST];
+uint8_t BlackBox::writeIdx = 0;
+uint8_t BlackBox::postCount = 0;
+uint8_t BlackBox::lastOpmode = MOD_OFF;
+uint16_t BlackBox::numSamples = 0;
+uint32_t BlackBox::triggerTime = 0;
+BlackBox::state BlackBox::bbState = BlackBox::ARMED;
+BlackBox::reason BlackBox::bbReason = BlackBox::TRG_NONE;
+
+void BlackBox::Sample()
+{
+    uint8_t opmode = Param::GetInt(Param::opmode);
+
+    //Leaving run for anything but an orderly shutdown request is a fault drop
+    if (lastOpmode == MOD_RUN && opmode != MOD_RUN && opmode != MOD_SHUTDOWN_REQUEST)
+        Trigger(TRG_RUNDROP);
+
+    lastOpmode = opmode;
+
+    if (bbState == FROZEN) return;
+
+    for (int i = 0; i < SIG_LAST; i++)
+    {
+        float val = Param::GetFloat(signalParams[i]) * signalScales[i];
+
+        if (val > INT16_MAX) val = INT16_MAX;
+        else if (val < INT16_MIN) val = INT16_MIN;
+
+        buffer[writeIdx][i] = (int16_t)val;
+    }
+
+    writeIdx = (writeIdx + 1) % BB_SAMPLES;
+    if (numSamples < BB_SAMPLES) numSamples++;
+
+    if (bbState == TRIGGERED)
+    {
+        postCount++;
+        if (postCount >= BB_POST_SAMPLES) bbState = FROZEN;
+    }
+
+    Param::SetInt(Param::BBState, bbState);
+}
+
+void BlackBox::Trigger(reason r)
+{
+    //Only the first event is recorded, repeated posts of the same error are ignored
+    if (bbState != ARMED) return;
+
+    bbState = TRIGGERED;
+    bbReason = r;
+    postCount = 0;
+    triggerTime = rtc_get_counter_val();
+    Param::SetInt(Param::BBState, bbState);
+}
+
+void BlackBox::Arm()
+{
+    writeIdx = 0;
+    numSamples = 0;
+    postCount = 0;
+    bbReason = TRG_NONE;
+    bbState = ARMED;
+    Param::SetInt(Param::BBState, bbState);
+}
+
+//sample 0 is the oldest sample in the buffer
+int32_t BlackBox::GetSample(int sample, int signal)
+{
+    int idx = (writeIdx + BB_SAMPLES - numSamples + sample) % BB_SAMPLES;
+    return buffer[idx][signal];
+}
+
+void BlackBox::Print(IPutChar* out)
+{
+    static const char* stateNames[] = { "armed", "triggered", "frozen" };
+    //index of the sample taken in the trigger tick, relative to the oldest sample
+    int trgIdx = bbState == ARMED ? -1 : numSamples - postCount;
+
+    fprintf(out, "state=%s reason=%d time=%u samples=%d trigger=%d period=10ms\r\n",
+            stateNames[bbState], bbReason, (unsigned)triggerTime, numSamples, trgIdx);
+
+    fprintf(out, "n");
+    for (int i = 0; i < SIG_LAST; i++)
+        fprintf(out, ",%s", signalNames[i]);
+    fprintf(out, "\r\n");
+
+    for (int s = 0; s < numSamples; s++)
+    {
+        fprintf(out, "%d", s - trgIdx);
+        for (int i = 0; i < SIG_LAST; i++)
+        {
+            int32_t val = GetSample(s, i);
+            if (signalScales[i] != 1)
+            {
+                //print scaled values with one decimal, scales are powers of 10
+                fprintf(out, ",%s%d.%d", val < 0 ? "-" : "", (int)(ABS(val) / signalScales[i]), (int)(ABS(val) % signalScales[i]));
+            }
+            else
+            {
+                fprintf(out, ",%d", (int)val);
+            }
+        }
+        fprintf(out, "\r\n");
+    }
+}
+
+uint32_t BlackBox::GetRecordSize()
+{
+    return BB_HEADER_SIZE + numSamples * SIG_LAST * sizeof(int16_t);
+}
+
+/* Raw recording for bulk transfer: state, reason, number of samples, post trigger samples,
+ * RTC time of the trigger (uint32), followed by the samples oldest first, each sample
+ * SIG_LAST int16 values in BB_SIGNAL_LIST order. Everything little endian.
+ */
+uint32_t BlackBox::ReadRecord(uint32_t offset, uint8_t* data, uint32_t len)
+{
+    uint8_t header[BB_HEADER_SIZE] = { (uint8_t)bbState, (uint8_t)bbReason, (uint8_t)numSamples, postCount,
+                                       (uint8_t)triggerTime, (uint8_t)(triggerTime >> 8),
+                                       (uint8_t)(triggerTime >> 16), (uint8_t)(triggerTime >> 24) };
+    uint32_t recordSize = GetRecordSize();
+    uint32_t i;
+
+    for (i = 0; i < len && offset < recordSize; i++, offset++)
+    {
+        if (offset < BB_HEADER_SIZE)
+        {
+            data[i] = header[offset];
+        }
+        else
+        {
+            uint32_t pos = offset - BB_HEADER_SIZE;
+            uint32_t val = GetSample(pos / (SIG_LAST * 2), (pos / 2) % SIG_LAST);
+            data[i] = (pos & 1) ? val >> 8 : val;
+        }
+    }
+    return i;
+}
+
+/* Object 0x4100 sub 0: read returns state | reason << 8 | samples << 16 | post trigger samples << 24,
+ *                      any write re-arms
+ *                sub 1: read returns RTC time of the trigger
+ * Object 0x4101 + n sub s: read returns raw value of signal s in sample n, n = 0 is the oldest
+ */
+bool BlackBox::ProcessSdo(CanSdo::SdoFrame* sdo)
+{
+    if (sdo->index < BB_SDO_INDEX || sdo->index > (BB_SDO_INDEX + BB_SAMPLES))
+        return false;
+
+    if (sdo->index == BB_SDO_INDEX)
+    {
+        if (sdo->cmd == BB_SDO_WRITE)
+        {
+            Arm();
+            sdo->cmd = BB_SDO_WRITE_REPLY;
+        }
+        else if (sdo->subIndex == 0)
+        {
+            sdo->data = bbState | (bbReason << 8) | (numSamples << 16) | (postCount << 24);
+            sdo->cmd = BB_SDO_READ_REPLY;
+        }
+        else if (sdo->subIndex == 1)
+        {
+            sdo->data = triggerTime;
+            sdo->cmd = BB_SDO_READ_REPLY;
+        }
+        else
+        {
+            sdo->data = BB_SDO_ERR_INVIDX;
+            sdo->cmd = BB_SDO_ABORT;
+        }
+        return true;
+    }
+
+    int sample = sdo->index - BB_SDO_INDEX - 1;
+
+    if (sdo->cmd != BB_SDO_READ || sample >= numSamples || sdo->subIndex >= SIG_LAST)
+    {
+        sdo->data = BB_SDO_ERR_RANGE;
+        sdo->cmd = BB_SDO_ABORT;
+    }
+    else
+    {
+        sdo->data = GetSample(sample, sdo->subIndex);
+        sdo->cmd = BB_SDO_READ_REPLY;
+    }
+    return true;
+}
@@ -138,7 +138,7 @@ void SBOX::handle220(uint32_t data[2]) //SBOX Output voltage
 
 }
 
-void SBOX::ControlContactors(int opmode, CanHardware* can)
+void SBOX::ControlContactors(uint8_t contactors, CanHardware* can)
 {
    uint8_t bytes[8];
    bytes[0]=0xFF;//sems to control the iso relay
@@ -160,28 +160,12 @@ void SBOX::ControlContactors(int opmode, CanHardware* can)
    canCtr100++;
    if(canCtr100>0xE) canCtr100=0;
 
-      switch (opmode)
-   {
-      case 0:
-        CCByte=0x00;//all contactors off
-         break;
-      case 2://Precharge
-        CCByte=0xA6;//Prech and Neg contactors activated
-         break;
-
-      case 1://Run
-        CCByte=0xAA;//All contactors activated
-         break;
-
-      case 4://Charge
-        CCByte=0xAA;//All contactors activated
-         break;
-
-      case 3://Precharge fail
-        CCByte=0x00;//all contactors off
-         break;
-
-    }
+   if (contactors & ContactorSeq::CT_MAIN)
+      CCByte=0xAA;//All contactors activated
+   else if (contactors & ContactorSeq::CT_PRECHARGE)
+      CCByte=0xA6;//Prech and Neg contactors activated
+   else
+      CCByte=0x00;//all contactors off
    CRCByte = BMW_crc8(bytes,8);
    bytes[3]=CRCByte;//crc
    can->Send(0x100, (uint32_t*)bytes,4);
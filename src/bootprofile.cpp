@@ -0,0 +1,88 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bootprofile.h"
+#include "params.h"
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/stm32/rcc.h>
+
+#define BOOT_STAGE_ENTRY(stage, name) name,
+static const char* names[BOOT_STAGE_NUM] = { BOOT_STAGE_LIST };
+#undef BOOT_STAGE_ENTRY
+
+uint32_t BootProfile::stageUs[BOOT_STAGE_NUM];
+uint32_t BootProfile::lastCycles = 0;
+uint32_t BootProfile::totalUs = 0;
+uint32_t BootProfile::firstCanUs = 0;
+bool BootProfile::running = false;
+
+void BootProfile::Start()
+{
+    if (!dwt_enable_cycle_counter()) return;
+
+    DWT_CYCCNT = 0;
+    lastCycles = 0;
+    running = true;
+}
+
+void BootProfile::Mark(BootStage stage)
+{
+    if (!running) return;
+
+    uint32_t us = Elapsed();
+
+    stageUs[stage] += us;
+    totalUs += us;
+}
+
+void BootProfile::Finish()
+{
+    Mark(BOOT_DEFERRED);
+    running = false;
+    Param::SetInt(Param::BootTime, totalUs / 1000);
+}
+
+void BootProfile::FirstCan()
+{
+    if (firstCanUs != 0) return;
+
+    //Only meaningful within the first minute, the cycle counter wraps after that
+    uint32_t cyclesPerUs = rcc_ahb_frequency / 1000000;
+    firstCanUs = totalUs + (dwt_read_cycle_counter() - lastCycles) / cyclesPerUs;
+    Param::SetInt(Param::FirstCanTime, firstCanUs / 1000);
+}
+
+void BootProfile::Print(IPutChar* out)
+{
+    fprintf(out, "stage,us\r\n");
+    for (int i = 0; i < BOOT_STAGE_NUM; i++)
+        fprintf(out, "%s,%u\r\n", names[i], stageUs[i]);
+    fprintf(out, "total,%u\r\n", totalUs);
+    fprintf(out, "first can,%u\r\n", firstCanUs);
+}
+
+//Microseconds since the last call, counted at the clock running at the last call
+uint32_t BootProfile::Elapsed()
+{
+    static uint32_t cyclesPerUs = 8; //HSI until clock_setup()
+    uint32_t now = dwt_read_cycle_counter();
+    uint32_t us = (now - lastCycles) / cyclesPerUs;
+
+    lastCycles = now;
+    cyclesPerUs = rcc_ahb_frequency / 1000000;
+    return us;
+}
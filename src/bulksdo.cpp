@@ -0,0 +1,546 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bulksdo.h"
+#include "params.h"
+#include "my_math.h"
+#include "blackbox.h"
+#include "faultlog.h"
+
+//client command specifiers, upper 3 bits of byte 0
+#define CCS_DOWNLOAD_SEG     0x00
+#define CCS_DOWNLOAD_INIT    0x20
+#define CCS_UPLOAD_INIT      0x40
+#define CCS_UPLOAD_SEG       0x60
+#define CCS_ABORT            0x80
+#define CCS_BLOCK_UPLOAD     0xA0
+#define CCS_BLOCK_DOWNLOAD   0xC0
+
+#define BLKUP_CS_INIT        0
+#define BLKUP_CS_END         1
+#define BLKUP_CS_ACK         2
+#define BLKUP_CS_START       3
+
+#define SDO_ERR_TOGGLE       0x05030000
+#define SDO_ERR_TIMEOUT      0x05040000
+#define SDO_ERR_INVCMD       0x05040001
+#define SDO_ERR_BLKSIZE      0x05040002
+#define SDO_ERR_SEQNO        0x05040003
+#define SDO_ERR_READONLY     0x06010002
+#define SDO_ERR_INVIDX       0x06020000
+#define SDO_ERR_GENERAL      0x08000000
+
+#define PARAM_RECORD_SIZE    6
+
+const BulkSdo::Object BulkSdo::objects[] =
+{
+    { 0x5000, ParamSize, ParamRead, ParamWrite },
+    { 0x5001, BlackBox::GetRecordSize, BlackBox::ReadRecord, 0 },
+    { 0x5002, FaultLog::GetRecordSize, FaultLog::ReadRecord, 0 },
+};
+
+CanHardware* BulkSdo::can = 0;
+const BulkSdo::Object* BulkSdo::object = 0;
+volatile BulkSdo::xferstate BulkSdo::state = BulkSdo::IDLE;
+uint32_t BulkSdo::size = 0;
+uint32_t BulkSdo::offset = 0;
+uint32_t BulkSdo::blockStart = 0;
+uint8_t BulkSdo::toggle = 0;
+uint8_t BulkSdo::seqno = 0;
+uint8_t BulkSdo::blksize = 0;
+uint8_t BulkSdo::lastSegment[7];
+uint16_t BulkSdo::index = 0;
+uint8_t BulkSdo::subIndex = 0;
+uint16_t BulkSdo::timeout = 0;
+uint32_t BulkSdo::rxQueue[BULKSDO_RXQUEUE_SIZE][2];
+volatile uint8_t BulkSdo::rxHead = 0;
+volatile uint8_t BulkSdo::rxTail = 0;
+BulkSdo::ParamWriteReq BulkSdo::wrQueue[BULKSDO_WRQUEUE_SIZE];
+volatile uint8_t BulkSdo::wrHead = 0;
+volatile uint8_t BulkSdo::wrTail = 0;
+
+void BulkSdo::RegisterCanMessages(CanHardware* c)
+{
+    can = c;
+    can->RegisterUserMessage(BULKSDO_REQ_ID);
+}
+
+void BulkSdo::DecodeCAN(int id, uint32_t data[2])
+{
+    uint8_t next = (rxHead + 1) % BULKSDO_RXQUEUE_SIZE;
+
+    if (id != BULKSDO_REQ_ID || 0 == can) return;
+
+    //On overflow the frame is dropped, the client repeats it after a timeout or a block acknowledge
+    if (next == rxTail) return;
+
+    rxQueue[rxHead][0] = data[0];
+    rxQueue[rxHead][1] = data[1];
+    rxHead = next;
+}
+
+void BulkSdo::Task1Ms()
+{
+    //A frame can complete two parameter records, leave it queued until the main loop caught up
+    while (rxTail != rxHead && (wrTail + BULKSDO_WRQUEUE_SIZE - wrHead - 1) % BULKSDO_WRQUEUE_SIZE >= 2)
+    {
+        ProcessFrame((uint8_t*)rxQueue[rxTail]);
+        rxTail = (rxTail + 1) % BULKSDO_RXQUEUE_SIZE;
+    }
+
+    if (state != IDLE && timeout > 0)
+    {
+        timeout--;
+        if (timeout == 0) Abort(SDO_ERR_TIMEOUT);
+    }
+
+    //Block upload segments are paced here instead of being sent in one burst
+    for (int i = 0; i < BULKSDO_FRAMES_PER_MS && state == BLKUP_SEND; i++)
+    {
+        uint32_t frame[2] = { 0, 0 };
+        uint8_t* bytes = (uint8_t*)frame;
+        uint32_t len = MIN(7, size - offset);
+
+        object->Read(offset, &bytes[1], len);
+        offset += len;
+        seqno++;
+
+        bool last = offset >= size;
+        bytes[0] = (last ? 0x80 : 0) | seqno;
+        can->Send(BULKSDO_REP_ID, frame, 8);
+
+        if (last || seqno >= blksize)
+            state = BLKUP_WAITACK;
+    }
+}
+
+void BulkSdo::Run()
+{
+    while (wrTail != wrHead)
+    {
+        const ParamWriteReq& req = wrQueue[wrTail];
+
+        Param::Set(req.idx, req.value);
+        wrTail = (wrTail + 1) % BULKSDO_WRQUEUE_SIZE;
+    }
+}
+
+void BulkSdo::ProcessFrame(uint8_t* bytes)
+{
+    timeout = BULKSDO_TIMEOUT_MS;
+
+    //Block download segments carry a sequence number instead of a command specifier
+    if (state == BLKDN_RECV)
+    {
+        BlockDownloadSegment(bytes);
+        return;
+    }
+
+    switch (bytes[0] & 0xE0)
+    {
+    case CCS_DOWNLOAD_SEG:
+        DownloadSegment(bytes);
+        break;
+    case CCS_DOWNLOAD_INIT:
+        InitiateDownload(bytes);
+        break;
+    case CCS_UPLOAD_INIT:
+        InitiateUpload(bytes);
+        break;
+    case CCS_UPLOAD_SEG:
+        UploadSegment(bytes);
+        break;
+    case CCS_ABORT:
+        state = IDLE;
+        break;
+    case CCS_BLOCK_UPLOAD:
+        BlockUpload(bytes);
+        break;
+    case CCS_BLOCK_DOWNLOAD:
+        BlockDownload(bytes);
+        break;
+    default:
+        Abort(SDO_ERR_INVCMD);
+        break;
+    }
+}
+
+void BulkSdo::InitiateUpload(uint8_t* bytes)
+{
+    object = FindObject(bytes);
+
+    if (0 == object)
+    {
+        Abort(SDO_ERR_INVIDX);
+        return;
+    }
+
+    size = object->GetSize();
+    offset = 0;
+    toggle = 0;
+    state = UPLOAD_SEG;
+    Reply(0x41, size); //segmented, size indicated
+}
+
+void BulkSdo::UploadSegment(uint8_t* bytes)
+{
+    if (state != UPLOAD_SEG)
+    {
+        Abort(SDO_ERR_INVCMD);
+        return;
+    }
+    if ((bytes[0] & 0x10) != toggle)
+    {
+        Abort(SDO_ERR_TOGGLE);
+        return;
+    }
+
+    uint32_t frame[2] = { 0, 0 };
+    uint8_t* seg = (uint8_t*)frame;
+    uint32_t len = MIN(7, size - offset);
+
+    object->Read(offset, &seg[1], len);
+    offset += len;
+
+    bool last = offset >= size;
+    seg[0] = toggle | ((7 - len) << 1) | (last ? 1 : 0);
+    toggle ^= 0x10;
+
+    if (last) state = IDLE;
+
+    can->Send(BULKSDO_REP_ID, frame, 8);
+}
+
+void BulkSdo::InitiateDownload(uint8_t* bytes)
+{
+    object = FindObject(bytes);
+
+    if (0 == object)
+    {
+        Abort(SDO_ERR_INVIDX);
+    }
+    else if (0 == object->Write)
+    {
+        Abort(SDO_ERR_READONLY);
+    }
+    else if (bytes[0] & 0x02) //expedited
+    {
+        uint32_t len = (bytes[0] & 0x01) ? 4 - ((bytes[0] >> 2) & 3) : 4;
+
+        if (object->Write(0, &bytes[4], len))
+            Reply(0x60, 0);
+        else
+            Abort(SDO_ERR_GENERAL);
+    }
+    else
+    {
+        size = (bytes[0] & 0x01) ? ((uint32_t*)bytes)[1] : 0xFFFFFFFF;
+        offset = 0;
+        toggle = 0;
+        state = DOWNLOAD_SEG;
+        Reply(0x60, 0);
+    }
+}
+
+void BulkSdo::DownloadSegment(uint8_t* bytes)
+{
+    if (state != DOWNLOAD_SEG)
+    {
+        Abort(SDO_ERR_INVCMD);
+        return;
+    }
+    if ((bytes[0] & 0x10) != toggle)
+    {
+        Abort(SDO_ERR_TOGGLE);
+        return;
+    }
+
+    uint32_t len = 7 - ((bytes[0] >> 1) & 7);
+
+    if (!object->Write(offset, &bytes[1], len))
+    {
+        Abort(SDO_ERR_GENERAL);
+        return;
+    }
+
+    offset += len;
+
+    uint32_t frame[2] = { 0, 0 };
+    ((uint8_t*)frame)[0] = 0x20 | toggle;
+    toggle ^= 0x10;
+
+    if (bytes[0] & 0x01) state = IDLE;
+
+    can->Send(BULKSDO_REP_ID, frame, 8);
+}
+
+void BulkSdo::BlockUpload(uint8_t* bytes)
+{
+    switch (bytes[0] & 0x03)
+    {
+    case BLKUP_CS_INIT:
+        object = FindObject(bytes);
+
+        if (0 == object)
+        {
+            Abort(SDO_ERR_INVIDX);
+        }
+        else if (bytes[4] == 0 || bytes[4] > BULKSDO_MAX_BLKSIZE)
+        {
+            Abort(SDO_ERR_BLKSIZE);
+        }
+        else
+        {
+            blksize = bytes[4];
+            size = object->GetSize();
+            offset = 0;
+            blockStart = 0;
+            seqno = 0;
+            state = BLKUP_INIT;
+            Reply(0xC2, size); //no CRC, size indicated
+        }
+        break;
+    case BLKUP_CS_START:
+        if (state == BLKUP_INIT)
+            state = BLKUP_SEND;
+        else
+            Abort(SDO_ERR_INVCMD);
+        break;
+    case BLKUP_CS_ACK:
+        if (state != BLKUP_WAITACK)
+        {
+            Abort(SDO_ERR_INVCMD);
+        }
+        else if (bytes[1] > seqno)
+        {
+            Abort(SDO_ERR_SEQNO);
+        }
+        else if (bytes[1] == seqno && (blockStart + seqno * 7) >= size)
+        {
+            //All segments acknowledged, n is the number of unused bytes in the last segment
+            uint32_t frame[2] = { 0, 0 };
+            uint32_t lastLen = size - (blockStart + (seqno - 1) * 7);
+
+            ((uint8_t*)frame)[0] = 0xC1 | ((7 - lastLen) << 2);
+            state = BLKUP_END;
+            can->Send(BULKSDO_REP_ID, frame, 8);
+        }
+        else if (bytes[2] == 0 || bytes[2] > BULKSDO_MAX_BLKSIZE)
+        {
+            Abort(SDO_ERR_BLKSIZE);
+        }
+        else
+        {
+            //Continue after the last segment the client received, this also covers retransmission
+            blockStart = MIN(size, blockStart + bytes[1] * 7);
+            offset = blockStart;
+            blksize = bytes[2];
+            seqno = 0;
+            state = BLKUP_SEND;
+        }
+        break;
+    case BLKUP_CS_END:
+        if (state == BLKUP_END)
+            state = IDLE;
+        else
+            Abort(SDO_ERR_INVCMD);
+        break;
+    }
+}
+
+void BulkSdo::BlockDownload(uint8_t* bytes)
+{
+    if ((bytes[0] & 0x01) == 0) //initiate
+    {
+        object = FindObject(bytes);
+
+        if (0 == object)
+        {
+            Abort(SDO_ERR_INVIDX);
+        }
+        else if (0 == object->Write)
+        {
+            Abort(SDO_ERR_READONLY);
+        }
+        else
+        {
+            size = (bytes[0] & 0x02) ? ((uint32_t*)bytes)[1] : 0xFFFFFFFF;
+            offset = 0;
+            seqno = 0;
+            blksize = BULKSDO_RXQUEUE_SIZE - 1; //a whole block fits the receive queue
+            state = BLKDN_RECV;
+            Reply(0xA0, blksize); //no CRC
+        }
+    }
+    else if (state == BLKDN_END) //end, write out the used part of the last segment
+    {
+        uint32_t frame[2] = { 0, 0 };
+        uint32_t len = 7 - ((bytes[0] >> 2) & 7);
+
+        state = IDLE;
+
+        if (object->Write(offset, lastSegment, len))
+        {
+            ((uint8_t*)frame)[0] = 0xA1;
+            can->Send(BULKSDO_REP_ID, frame, 8);
+        }
+        else
+        {
+            Abort(SDO_ERR_GENERAL);
+        }
+    }
+    else
+    {
+        Abort(SDO_ERR_INVCMD);
+    }
+}
+
+void BulkSdo::BlockDownloadSegment(uint8_t* bytes)
+{
+    uint8_t seq = bytes[0] & 0x7F;
+    bool last = (bytes[0] & 0x80) != 0;
+    bool lastAccepted = false;
+
+    if (bytes[0] == CCS_ABORT) //sequence number 0 is never used, this is an abort
+    {
+        state = IDLE;
+        return;
+    }
+
+    //Out of order segments are dropped, the acknowledge makes the client repeat them
+    if (seq == seqno + 1)
+    {
+        seqno = seq;
+
+        if (last)
+        {
+            //Number of valid bytes is only known from the end frame
+            for (int i = 0; i < 7; i++)
+                lastSegment[i] = bytes[i + 1];
+            lastAccepted = true;
+        }
+        else if (object->Write(offset, &bytes[1], 7))
+        {
+            offset += 7;
+        }
+        else
+        {
+            Abort(SDO_ERR_GENERAL);
+            return;
+        }
+    }
+
+    if (last || seq >= blksize)
+    {
+        uint32_t frame[2] = { 0, 0 };
+        uint8_t* ack = (uint8_t*)frame;
+
+        ack[0] = 0xA2;
+        ack[1] = seqno;
+        ack[2] = blksize;
+        seqno = 0;
+
+        if (lastAccepted) state = BLKDN_END;
+
+        can->Send(BULKSDO_REP_ID, frame, 8);
+    }
+}
+
+const BulkSdo::Object* BulkSdo::FindObject(uint8_t* bytes)
+{
+    index = bytes[1] | (bytes[2] << 8);
+    subIndex = bytes[3];
+
+    if (subIndex != 0) return 0;
+
+    for (uint32_t i = 0; i < sizeof(objects) / sizeof(objects[0]); i++)
+    {
+        if (objects[i].index == index)
+            return &objects[i];
+    }
+    return 0;
+}
+
+void BulkSdo::Reply(uint8_t cmd, uint32_t data)
+{
+    uint32_t frame[2];
+    uint8_t* bytes = (uint8_t*)frame;
+
+    bytes[0] = cmd;
+    bytes[1] = index & 0xFF;
+    bytes[2] = index >> 8;
+    bytes[3] = subIndex;
+    frame[1] = data;
+    can->Send(BULKSDO_REP_ID, frame, 8);
+}
+
+void BulkSdo::Abort(uint32_t code)
+{
+    state = IDLE;
+    Reply(CCS_ABORT, code);
+}
+
+uint32_t BulkSdo::ParamSize()
+{
+    return Param::PARAM_LAST * PARAM_RECORD_SIZE;
+}
+
+uint32_t BulkSdo::ParamRead(uint32_t offset, uint8_t* data, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++, offset++)
+    {
+        Param::PARAM_NUM idx = (Param::PARAM_NUM)(offset / PARAM_RECORD_SIZE);
+        uint32_t pos = offset % PARAM_RECORD_SIZE;
+        uint32_t id = Param::GetAttrib(idx)->id;
+        uint32_t value = Param::Get(idx);
+
+        data[i] = pos < 2 ? id >> (8 * pos) : value >> (8 * (pos - 2));
+    }
+    return len;
+}
+
+bool BulkSdo::ParamWrite(uint32_t offset, const uint8_t* data, uint32_t len)
+{
+    static uint8_t record[PARAM_RECORD_SIZE];
+
+    for (uint32_t i = 0; i < len; i++, offset++)
+    {
+        uint32_t pos = offset % PARAM_RECORD_SIZE;
+
+        record[pos] = data[i];
+
+        if (pos == (PARAM_RECORD_SIZE - 1))
+        {
+            uint32_t id = record[0] | (record[1] << 8);
+            int32_t value = record[2] | (record[3] << 8) | (record[4] << 16) | (record[5] << 24);
+            Param::PARAM_NUM idx = Param::NumFromId(id);
+
+            uint8_t next = (wrHead + 1) % BULKSDO_WRQUEUE_SIZE;
+
+            //Unknown ids and spot values are skipped so an uploaded set can be written back as is
+            if (idx != Param::PARAM_INVALID && Param::GetType(idx) == Param::TYPE_PARAM)
+            {
+                if (next == wrTail) return false;
+
+                wrQueue[wrHead].idx = idx;
+                wrQueue[wrHead].value = value;
+                wrHead = next;
+            }
+        }
+    }
+    return true;
+}
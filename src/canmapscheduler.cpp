@@ -0,0 +1,173 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "canmapscheduler.h"
+#include "params.h"
+
+#define RATE_ONCHANGE 6 //CANRATES from this value up are on-change
+
+//period in 10ms ticks for CANRATES
+static const uint8_t periodTicks[] = { 1, 2, 5, 10, 20, 100 };
+
+static const Param::PARAM_NUM idParams[CANMAP_SCHED_NUM_IDS] =
+{
+    Param::CanMapId1, Param::CanMapId2, Param::CanMapId3, Param::CanMapId4
+};
+
+static const Param::PARAM_NUM rateParams[CANMAP_SCHED_NUM_IDS] =
+{
+    Param::CanMapRate1, Param::CanMapRate2, Param::CanMapRate3, Param::CanMapRate4
+};
+
+CanMapScheduler::CanMapScheduler(CanHardware* hw)
+    : hw(hw), numMessages(0), tick(0), sentFrames(0)
+{
+    hw->AddCallback(this);
+}
+
+void CanMapScheduler::Run(CanMap* map)
+{
+    int kept = 0;
+
+    tick = (tick + 1) % CANMAP_SCHED_WRAP;
+
+    for (int i = 0; i < numMessages; i++)
+        messages[i].seen = false;
+
+    map->SendAll(); //Comes back through Send() once per mapped message
+
+    //Drop ids that are no longer mapped so a remap doesn't fill up the table
+    for (int i = 0; i < numMessages; i++)
+    {
+        if (messages[i].seen)
+            messages[kept++] = messages[i];
+    }
+    numMessages = kept;
+}
+
+void CanMapScheduler::Send(uint32_t canId, uint32_t data[2], uint8_t len)
+{
+    Message* msg = 0;
+
+    for (int i = 0; i < numMessages; i++)
+    {
+        if (messages[i].canId == canId)
+        {
+            msg = &messages[i];
+            break;
+        }
+    }
+
+    if (0 == msg)
+    {
+        if (numMessages >= CANMAP_SCHED_MAX_MSG)
+        {
+            //No room to track it, fall back to the default period
+            if ((tick % CANMAP_SCHED_FALLBACK) == 0)
+            {
+                hw->Send(canId, data, len);
+                sentFrames++;
+            }
+            return;
+        }
+
+        msg = &messages[numMessages];
+        msg->canId = canId;
+        msg->slot = FreeSlot();
+        msg->lastSent = (tick + CANMAP_SCHED_WRAP - CANMAP_SCHED_KEEPALIVE) % CANMAP_SCHED_WRAP; //send on first occasion
+        numMessages++;
+    }
+
+    msg->seen = true;
+
+    int rate = GetRate(canId);
+    uint16_t elapsed = (tick + CANMAP_SCHED_WRAP - msg->lastSent) % CANMAP_SCHED_WRAP;
+    bool send;
+
+    if (rate >= RATE_ONCHANGE)
+    {
+        uint8_t period = periodTicks[rate - RATE_ONCHANGE];
+        bool changed = data[0] != msg->data[0] || data[1] != msg->data[1];
+        send = (changed && elapsed >= period) || elapsed >= CANMAP_SCHED_KEEPALIVE;
+    }
+    else
+    {
+        //The slot offset spreads messages with the same period over different ticks
+        send = ((tick + msg->slot) % periodTicks[rate]) == 0;
+    }
+
+    if (send)
+    {
+        msg->data[0] = data[0];
+        msg->data[1] = data[1];
+        msg->lastSent = tick;
+        hw->Send(canId, data, len);
+        sentFrames++;
+    }
+}
+
+void CanMapScheduler::SetBaudrate(enum baudrates baudrate)
+{
+    hw->SetBaudrate(baudrate);
+}
+
+bool CanMapScheduler::HandleRx(uint32_t canId, uint32_t data[2], uint8_t dlc)
+{
+    CanHardware::HandleRx(canId, data, dlc); //pass on to CanMap
+    return false;
+}
+
+void CanMapScheduler::HandleClear()
+{
+    //The hardware dropped all registrations, have CanMap register its ids again
+    ClearUserMessages();
+    //The map is usually being rebuilt, start over with the ids that come back
+    numMessages = 0;
+}
+
+void CanMapScheduler::ConfigureFilters()
+{
+    for (int i = 0; i < nextUserMessageIndex; i++)
+        hw->RegisterUserMessage(userIds[i]);
+}
+
+//Lowest slot not taken by a tracked message, pruning leaves gaps
+uint8_t CanMapScheduler::FreeSlot()
+{
+    static_assert(CANMAP_SCHED_MAX_MSG <= 32, "Slots are tracked in a 32 bit mask");
+    uint32_t used = 0;
+
+    for (int i = 0; i < numMessages; i++)
+        used |= 1u << messages[i].slot;
+
+    uint8_t slot = 0;
+
+    while (used & (1u << slot))
+        slot++;
+
+    return slot;
+}
+
+int CanMapScheduler::GetRate(uint32_t canId)
+{
+    for (int i = 0; i < CANMAP_SCHED_NUM_IDS; i++)
+    {
+        if (Param::GetInt(idParams[i]) == (int)canId)
+            return Param::GetInt(rateParams[i]);
+    }
+    return Param::GetInt(Param::CanMapRate);
+}
@@ -18,6 +18,7 @@
  */
 
 #include "chademo.h"
+#include "sequence.h"
 
 
 bool FCChademo::chargeEnabled = false;
@@ -39,14 +40,19 @@ uint32_t FCChademo::curTimeout = 0;
 static uint32_t chademoStartTime = 0;
 
 uCAN_MSG txMessage;
+static uCAN_MSG frames[3];
 
-#define FLASH_DELAY 8000
-static void delay(void)
+static void SendFrame(int i) { CANSPI_Transmit(&frames[i]); }
+
+//Gives the MCP2515 time to send each frame before loading the next one
+static const Sequence::Step sendSteps[] =
 {
-   int i;
-   for (i = 0; i < FLASH_DELAY; i++)       /* Wait a bit. */
-      __asm__("nop");
-}
+   { SendFrame, 0, SEQ_PERIOD_MS },
+   { SendFrame, 1, SEQ_PERIOD_MS },
+   { SendFrame, 2, SEQ_PERIOD_MS }
+};
+
+static Sequence sendSeq("chademo", SEQUENCE_STEPS(sendSteps));
 
 void FCChademo::DecodeCAN(int id, uint32_t data[2])
 {
@@ -134,8 +140,7 @@ void FCChademo::Task100Ms()//sends chademo messages every 100ms
    txMessage.frame.data5 = (data[1]>>8 & 0xFF);
    txMessage.frame.data6 = (data[1]>>16 & 0xFF);
    txMessage.frame.data7 = (data[1]>>24 & 0xFF);
-   CANSPI_Transmit(&txMessage);
-   delay();
+   frames[0] = txMessage;
 
    data[0] = 0x00FEFF00;
    data[1] = 0;
@@ -151,8 +156,7 @@ void FCChademo::Task100Ms()//sends chademo messages every 100ms
    txMessage.frame.data5 = (data[1]>>8 & 0xFF);
    txMessage.frame.data6 = (data[1]>>16 & 0xFF);
    txMessage.frame.data7 = (data[1]>>24 & 0xFF);
-   CANSPI_Transmit(&txMessage);
-   delay();
+   frames[1] = txMessage;
 
 
    data[0] = 1 | ((uint32_t)targetBatteryVoltage << 8) | ((uint32_t)rampedCurReq << 24);
@@ -175,7 +179,8 @@ void FCChademo::Task100Ms()//sends chademo messages every 100ms
    txMessage.frame.data5 = (data[1]>>8 & 0xFF);
    txMessage.frame.data6 = (data[1]>>16 & 0xFF);
    txMessage.frame.data7 = (data[1]>>24 & 0xFF);
-   CANSPI_Transmit(&txMessage);
+   frames[2] = txMessage;
+   sendSeq.Start();
 }
 
 
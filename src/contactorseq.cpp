@@ -0,0 +1,205 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "contactorseq.h"
+#include "params.h"
+
+#define SEQUENCE(from, to, steps) { from, to, steps, sizeof(steps) / sizeof(steps[0]) }
+
+typedef ContactorSeq CS;
+
+/////////////////////////////////////////////////////////////////////////////
+//Own outputs: dcsw_out (main), prec_out and the NEGCONTACTOR function pin
+static const CS::Step localOff[] =             { { 0, CS::CTC_NONE, 0, 0, CS::CTC_NONE } };
+//Give the HV devices time to settle after they have been told we are off
+static const CS::Step localOffAfterShutdown[] =
+{
+    { CS::CT_HOLD, CS::CTC_NONE, 2500, 0, CS::CTC_DEVICES_IDLE | CS::CTC_CURRENT_LOW },
+    { 0, CS::CTC_NONE, 0, 0, CS::CTC_NONE }
+};
+//Don't pull in the negative and precharge contactor at the same time
+static const CS::Step localPrecharge[] =
+{
+    { CS::CT_NEGATIVE, CS::CTC_NONE, 250, 0, CS::CTC_NONE },
+    { CS::CT_NEGATIVE | CS::CT_PRECHARGE, CS::CTC_NONE, 0, 0, CS::CTC_NONE }
+};
+static const CS::Step localPrechargeNoNeg[] =  { { CS::CT_NEGATIVE | CS::CT_PRECHARGE, CS::CTC_NONE, 0, 0, CS::CTC_NONE } };
+static const CS::Step localPchFail[] =         { { CS::CT_NEGATIVE, CS::CTC_NONE, 0, 0, CS::CTC_NONE } };
+//Precharge stays closed in case the main contactor drops out
+static const CS::Step localRun[] =
+{
+    { CS::CT_NEGATIVE | CS::CT_PRECHARGE, CS::CTC_NONE, 250, 0, CS::CTC_NONE },
+    { CS::CT_ALL, CS::CTC_NONE, 0, 0, CS::CTC_NONE }
+};
+static const CS::Step localCharge[] =
+{
+    { CS::CT_NEGATIVE | CS::CT_PRECHARGE, CS::CTC_NONE, 5000, 0, CS::CTC_NONE },
+    { CS::CT_ALL, CS::CTC_NONE, 0, 0, CS::CTC_NONE }
+};
+//Started during a preheat, the bus is precharged and may carry the heater current
+static const CS::Step localChargeToRun[] =     { { CS::CT_ALL, CS::CTC_NONE, 0, 0, CS::CTC_NONE } };
+//HV stays live so downstream devices can wind down, done when no current flows
+static const CS::Step localShutdown[] =        { { CS::CT_ALL, CS::CTC_CURRENT_LOW, 1500, 0, CS::CTC_DEVICES_IDLE } };
+
+static const CS::Sequence local[] =
+{
+    SEQUENCE(MOD_SHUTDOWN_REQUEST, MOD_OFF, localOffAfterShutdown),
+    SEQUENCE(CTS_ANY, MOD_OFF, localOff),
+    SEQUENCE(CTS_ANY, MOD_PRECHARGE, localPrecharge),
+    SEQUENCE(CTS_ANY, MOD_PCHFAIL, localPchFail),
+    SEQUENCE(MOD_CHARGE, MOD_RUN, localChargeToRun),
+    SEQUENCE(CTS_ANY, MOD_RUN, localRun),
+    SEQUENCE(CTS_ANY, MOD_CHARGE, localCharge),
+    SEQUENCE(CTS_ANY, MOD_SHUTDOWN_REQUEST, localShutdown)
+};
+
+static const CS::Sequence localNoNeg[] =
+{
+    SEQUENCE(MOD_SHUTDOWN_REQUEST, MOD_OFF, localOffAfterShutdown),
+    SEQUENCE(CTS_ANY, MOD_OFF, localOff),
+    SEQUENCE(CTS_ANY, MOD_PRECHARGE, localPrechargeNoNeg),
+    SEQUENCE(CTS_ANY, MOD_PCHFAIL, localPchFail),
+    SEQUENCE(MOD_CHARGE, MOD_RUN, localChargeToRun),
+    SEQUENCE(CTS_ANY, MOD_RUN, localRun),
+    SEQUENCE(CTS_ANY, MOD_CHARGE, localCharge),
+    SEQUENCE(CTS_ANY, MOD_SHUTDOWN_REQUEST, localShutdown)
+};
+
+/////////////////////////////////////////////////////////////////////////////
+//Contactor boxes sequence themselves, we only tell them the target state
+static const CS::Step boxOff[] =               { { 0, CS::CTC_NONE, 0, 0, CS::CTC_NONE } };
+static const CS::Step boxPrecharge[] =         { { CS::CT_NEGATIVE | CS::CT_PRECHARGE, CS::CTC_NONE, 0, 0, CS::CTC_NONE } };
+static const CS::Step boxAll[] =               { { CS::CT_ALL, CS::CTC_NONE, 0, 0, CS::CTC_NONE } };
+static const CS::Step boxMain[] =              { { CS::CT_NEGATIVE | CS::CT_MAIN, CS::CTC_NONE, 0, 0, CS::CTC_NONE } };
+
+static const CS::Sequence box[] =
+{
+    SEQUENCE(CTS_ANY, MOD_OFF, boxOff),
+    SEQUENCE(CTS_ANY, MOD_PRECHARGE, boxPrecharge),
+    SEQUENCE(CTS_ANY, MOD_PCHFAIL, boxOff),
+    SEQUENCE(CTS_ANY, MOD_RUN, boxAll),
+    SEQUENCE(CTS_ANY, MOD_CHARGE, boxAll),
+    SEQUENCE(CTS_ANY, MOD_SHUTDOWN_REQUEST, boxAll)
+};
+
+//The HVCU opens the precharge relay once the main contactor is closed
+static const CS::Sequence hvcu[] =
+{
+    SEQUENCE(CTS_ANY, MOD_OFF, boxOff),
+    SEQUENCE(CTS_ANY, MOD_PRECHARGE, boxPrecharge),
+    SEQUENCE(CTS_ANY, MOD_PCHFAIL, boxOff),
+    SEQUENCE(CTS_ANY, MOD_RUN, boxMain),
+    SEQUENCE(CTS_ANY, MOD_CHARGE, boxMain),
+    SEQUENCE(CTS_ANY, MOD_SHUTDOWN_REQUEST, boxMain)
+};
+
+static const struct
+{
+    const CS::Sequence* sequences;
+    uint8_t numSequences;
+} topologies[CS::TOP_LAST] =
+{
+    { local, sizeof(local) / sizeof(local[0]) },
+    { localNoNeg, sizeof(localNoNeg) / sizeof(localNoNeg[0]) },
+    { box, sizeof(box) / sizeof(box[0]) },
+    { box, sizeof(box) / sizeof(box[0]) },
+    { hvcu, sizeof(hvcu) / sizeof(hvcu[0]) }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+ContactorSeq::LogEntry ContactorSeq::log[CTS_LOG_SIZE];
+uint8_t ContactorSeq::logPos = 0;
+uint8_t ContactorSeq::logCount = 0;
+
+//Starts out off with nothing to do
+ContactorSeq::ContactorSeq(Topology t)
+    : topology(t), opmode(MOD_OFF), steps(0), numSteps(0), step(0), outputs(0), held(0), stepTime(0), fault(false)
+{
+}
+
+/** Takes effect on the next opmode change */
+void ContactorSeq::SetTopology(Topology t)
+{
+    topology = t;
+}
+
+uint8_t ContactorSeq::Run(int mode, uint8_t conditions)
+{
+    if (mode != opmode) Start(mode);
+
+    //Completes as many steps as are ready, so zero time steps don't cost a period each
+    while (step < numSteps)
+    {
+        const Step& s = steps[step];
+
+        outputs = (s.outputs & CT_HOLD) ? held : s.outputs;
+
+        bool early = s.finishEarly != 0 && (s.finishEarly & conditions) == s.finishEarly;
+
+        if ((stepTime < s.minMs && !early) || (s.conditions & conditions) != s.conditions)
+        {
+            if (s.maxMs > 0 && stepTime >= s.maxMs) fault = true;
+            stepTime += CTS_PERIOD_MS;
+            break;
+        }
+
+        LogEntry& e = log[logPos];
+        e.topology = topology;
+        e.opmode = opmode;
+        e.step = step;
+        e.ms = stepTime;
+        logPos = (logPos + 1) % CTS_LOG_SIZE;
+        if (logCount < CTS_LOG_SIZE) logCount++;
+
+        step++;
+        stepTime = 0;
+    }
+
+    return outputs;
+}
+
+const ContactorSeq::LogEntry* ContactorSeq::GetLog(int i)
+{
+    if (i >= logCount) return 0;
+    return &log[(logPos + CTS_LOG_SIZE - 1 - i) % CTS_LOG_SIZE];
+}
+
+void ContactorSeq::Start(int mode)
+{
+    const auto& top = topologies[topology];
+
+    steps = 0;
+    numSteps = 0;
+
+    for (int i = 0; i < top.numSequences; i++)
+    {
+        const Sequence& seq = top.sequences[i];
+
+        if (seq.to == mode && (seq.from == opmode || seq.from == CTS_ANY))
+        {
+            steps = seq.steps;
+            numSteps = seq.numSteps;
+            break;
+        }
+    }
+
+    opmode = mode;
+    held = outputs;
+    step = 0;
+    stepTime = 0;
+    fault = false;
+}
@@ -0,0 +1,349 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "faultlog.h"
+#include "params.h"
+#include "hwdefs.h"
+#include <libopencm3/stm32/flash.h>
+#include <libopencm3/stm32/desig.h>
+#include <libopencm3/stm32/rtc.h>
+#include <libopencm3/cm3/cortex.h>
+
+/* Flash layout: two pages used alternately. Each starts with a 16 byte header
+ * (magic, sequence number) followed by Entry records. When switching pages the
+ * occurrence counters are carried over as records with CARRY_FLAG set.
+ */
+#define FAULTLOG_MAGIC   0x474F4C46 //"FLOG"
+#define HEADER_SIZE      16
+#define SLOTS            ((FLASH_PAGE_SIZE - HEADER_SIZE) / sizeof(FaultLog::Entry))
+#define ENTRY_HW         (sizeof(FaultLog::Entry) / 2)
+#define CARRY_FLAG       0x80
+#define ERASED           0xFF
+
+//The half word holding err is programmed last so a torn write is never mistaken for an event
+static const uint8_t programOrder[ENTRY_HW] = { 0, 1, 3, 4, 5, 6, 7, 2 };
+
+#define ERROR_MESSAGE_ENTRY(id, type) #id,
+static const char* errorNames[] = { "NONE", ERROR_MESSAGE_LIST };
+#undef ERROR_MESSAGE_ENTRY
+
+FaultLog::Entry FaultLog::entries[FAULTLOG_SIZE];
+uint16_t FaultLog::counts[ERROR_MESSAGE_LAST];
+uint8_t FaultLog::active[ERROR_MESSAGE_LAST];
+volatile uint8_t FaultLog::head = 0;
+volatile uint8_t FaultLog::numEntries = 0;
+volatile uint8_t FaultLog::unsaved = 0;
+int8_t FaultLog::curPage = -1;
+uint32_t FaultLog::curSeq = 0;
+uint16_t FaultLog::nextSlot = 0;
+uint8_t FaultLog::hwWritten = 0;
+volatile bool FaultLog::overrun = false;
+
+void FaultLog::Init()
+{
+    const uint32_t* hdr0 = (const uint32_t*)PageAddress(0);
+    const uint32_t* hdr1 = (const uint32_t*)PageAddress(1);
+    bool valid0 = hdr0[0] == FAULTLOG_MAGIC;
+    bool valid1 = hdr1[0] == FAULTLOG_MAGIC;
+
+    //Load the older page first so the RAM history ends with the newest events
+    if (valid0 && valid1)
+    {
+        int newer = hdr1[1] > hdr0[1] ? 1 : 0;
+        LoadPage(1 - newer);
+        LoadPage(newer);
+        curPage = newer;
+    }
+    else if (valid0 || valid1)
+    {
+        curPage = valid0 ? 0 : 1;
+        LoadPage(curPage);
+    }
+
+    if (curPage >= 0)
+        curSeq = ((const uint32_t*)PageAddress(curPage))[1];
+
+    unsaved = 0;
+}
+
+void FaultLog::Post(ERROR_MESSAGE_NUM err)
+{
+    ErrorMessage::Post(err);
+
+    if (err <= ERROR_NONE || err >= ERROR_MESSAGE_LAST) return;
+
+    //Posted from tasks and the CAN interrupt, the same error must not be recorded twice
+    uint32_t mask = cm_mask_interrupts(1);
+
+    if (active[err] == 0)
+    {
+        Entry e;
+
+        if (counts[err] < 0xFFFF) counts[err]++;
+
+        e.uptime = rtc_get_counter_val();
+        e.err = err;
+        e.opmode = Param::GetInt(Param::opmode);
+        e.count = counts[err];
+        e.clock = (Param::GetInt(Param::Day) * 24 + Param::GetInt(Param::Hour)) * 60 + Param::GetInt(Param::Min);
+        e.speed = Param::GetInt(Param::speed);
+        e.udc = Param::GetInt(Param::udc);
+        e.idc = Param::GetInt(Param::idc);
+
+        //The oldest unsaved entry, possibly half programmed, is about to be overwritten
+        if (unsaved >= FAULTLOG_SIZE) overrun = true;
+        AddEntry(e);
+        if (unsaved < FAULTLOG_SIZE) unsaved++;
+    }
+
+    active[err] = FAULTLOG_REARM;
+    cm_mask_interrupts(mask);
+}
+
+void FaultLog::Task100Ms()
+{
+    uint32_t mask = cm_mask_interrupts(1);
+
+    for (int i = 0; i < ERROR_MESSAGE_LAST; i++)
+    {
+        if (active[i] > 0) active[i]--;
+    }
+    cm_mask_interrupts(mask);
+}
+
+void FaultLog::Run()
+{
+    if (unsaved == 0) return;
+
+    if (curPage < 0 || nextSlot >= SLOTS)
+    {
+        //Page erase halts the CPU for tens of ms, never do it while driving or charging
+        if (Param::GetInt(Param::opmode) == MOD_OFF)
+            StartPage(curPage < 0 ? 0 : 1 - curPage, curSeq + 1);
+        return;
+    }
+
+    //Post() may run in between, so work on a copy and only commit the progress if it didn't
+    uint32_t mask = cm_mask_interrupts(1);
+    if (overrun && hwWritten > 0)
+    {
+        //The entry being programmed was overwritten, give up its slot
+        hwWritten = 0;
+        nextSlot++;
+    }
+    overrun = false;
+    Entry e = entries[(head + FAULTLOG_SIZE - unsaved) % FAULTLOG_SIZE];
+    cm_mask_interrupts(mask);
+
+    if (nextSlot >= SLOTS) return;
+
+    uint32_t addr = PageAddress(curPage) + HEADER_SIZE + nextSlot * sizeof(Entry);
+    uint8_t written = hwWritten;
+
+    flash_unlock();
+    for (int i = 0; i < FAULTLOG_HW_PER_RUN && written < ENTRY_HW; i++, written++)
+    {
+        int hw = programOrder[written];
+        flash_program_half_word(addr + hw * 2, ((const uint16_t*)&e)[hw]);
+    }
+    flash_lock();
+
+    mask = cm_mask_interrupts(1);
+    if (overrun)
+    {
+        overrun = false;
+        hwWritten = 0;
+        nextSlot++;
+    }
+    else if (written >= ENTRY_HW)
+    {
+        hwWritten = 0;
+        nextSlot++;
+        unsaved--;
+    }
+    else
+    {
+        hwWritten = written;
+    }
+    cm_mask_interrupts(mask);
+}
+
+bool FaultLog::Clear()
+{
+    if (Param::GetInt(Param::opmode) != MOD_OFF) return false;
+
+    flash_unlock();
+    flash_erase_page(PageAddress(0));
+    flash_erase_page(PageAddress(1));
+    flash_lock();
+
+    uint32_t mask = cm_mask_interrupts(1);
+    for (int i = 0; i < ERROR_MESSAGE_LAST; i++)
+    {
+        counts[i] = 0;
+        active[i] = 0;
+    }
+
+    head = 0;
+    numEntries = 0;
+    unsaved = 0;
+    overrun = false;
+    curPage = -1;
+    curSeq = 0;
+    nextSlot = 0;
+    hwWritten = 0;
+    cm_mask_interrupts(mask);
+    return true;
+}
+
+void FaultLog::Print(IPutChar* out)
+{
+    static const char* days[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+
+    fprintf(out, "Occurrences\r\n");
+    for (int i = 1; i < ERROR_MESSAGE_LAST; i++)
+    {
+        if (counts[i] > 0)
+            fprintf(out, "%s: %d\r\n", errorNames[i], counts[i]);
+    }
+
+    fprintf(out, "uptime,clock,error,count,opmode,speed,udc,idc\r\n");
+    for (int i = 0; i < numEntries; i++)
+    {
+        const Entry& e = entries[(head + FAULTLOG_SIZE - numEntries + i) % FAULTLOG_SIZE];
+        int day = (e.clock / 1440) % 7;
+
+        fprintf(out, "%u,%s %d:%d%d,%s,%d,%d,%d,%d,%d\r\n", (unsigned)e.uptime, days[day], (e.clock / 60) % 24,
+                (e.clock % 60) / 10, e.clock % 10, errorNames[e.err], e.count, e.opmode, e.speed, e.udc, e.idc);
+    }
+}
+
+/* Bulk readout: number of errors, number of events, occurrence counter per error (uint16),
+ * then the events oldest first as Entry structs. Little endian.
+ */
+uint32_t FaultLog::GetRecordSize()
+{
+    return 2 + ERROR_MESSAGE_LAST * sizeof(uint16_t) + numEntries * sizeof(Entry);
+}
+
+uint32_t FaultLog::ReadRecord(uint32_t offset, uint8_t* data, uint32_t len)
+{
+    const uint32_t countsStart = 2;
+    const uint32_t entriesStart = countsStart + ERROR_MESSAGE_LAST * sizeof(uint16_t);
+    uint32_t recordSize = GetRecordSize();
+    uint32_t i;
+
+    for (i = 0; i < len && offset < recordSize; i++, offset++)
+    {
+        if (offset == 0)
+        {
+            data[i] = ERROR_MESSAGE_LAST;
+        }
+        else if (offset == 1)
+        {
+            data[i] = numEntries;
+        }
+        else if (offset < entriesStart)
+        {
+            data[i] = ((const uint8_t*)counts)[offset - countsStart];
+        }
+        else
+        {
+            uint32_t pos = offset - entriesStart;
+            const Entry& e = entries[(head + FAULTLOG_SIZE - numEntries + pos / sizeof(Entry)) % FAULTLOG_SIZE];
+            data[i] = ((const uint8_t*)&e)[pos % sizeof(Entry)];
+        }
+    }
+    return i;
+}
+
+uint32_t FaultLog::PageAddress(int page)
+{
+    return FLASH_BASE + desig_get_flash_size() * 1024 - (FAULTLOG_BLKNUM - page) * FLASH_PAGE_SIZE;
+}
+
+void FaultLog::AddEntry(const Entry& e)
+{
+    entries[head] = e;
+    head = (head + 1) % FAULTLOG_SIZE;
+    if (numEntries < FAULTLOG_SIZE) numEntries++;
+}
+
+void FaultLog::LoadPage(int page)
+{
+    uint32_t addr = PageAddress(page) + HEADER_SIZE;
+
+    nextSlot = SLOTS;
+
+    for (uint32_t slot = 0; slot < SLOTS; slot++, addr += sizeof(Entry))
+    {
+        const Entry* e = (const Entry*)addr;
+        const uint32_t* words = (const uint32_t*)addr;
+
+        if (words[0] == 0xFFFFFFFF && words[1] == 0xFFFFFFFF && words[2] == 0xFFFFFFFF && words[3] == 0xFFFFFFFF)
+        {
+            nextSlot = slot;
+            break;
+        }
+
+        uint8_t err = e->err & ~CARRY_FLAG;
+
+        if (e->err == ERASED || err >= ERROR_MESSAGE_LAST) continue; //torn write
+
+        if (e->count > counts[err]) counts[err] = e->count;
+        if ((e->err & CARRY_FLAG) == 0) AddEntry(*e);
+    }
+}
+
+bool FaultLog::StartPage(int page, uint32_t seq)
+{
+    uint32_t addr = PageAddress(page);
+    uint16_t slot = 0;
+
+    flash_unlock();
+    flash_erase_page(addr);
+    flash_program_half_word(addr, FAULTLOG_MAGIC & 0xFFFF);
+    flash_program_half_word(addr + 2, FAULTLOG_MAGIC >> 16);
+    flash_program_half_word(addr + 4, seq & 0xFFFF);
+    flash_program_half_word(addr + 6, seq >> 16);
+
+    for (int i = 1; i < ERROR_MESSAGE_LAST; i++)
+    {
+        if (counts[i] > 0)
+        {
+            Entry carry = { 0, (uint8_t)(i | CARRY_FLAG), 0, counts[i], 0, 0, 0, 0 };
+            ProgramEntry(addr + HEADER_SIZE + slot * sizeof(Entry), carry);
+            slot++;
+        }
+    }
+    flash_lock();
+
+    curPage = page;
+    curSeq = seq;
+    nextSlot = slot;
+    hwWritten = 0;
+    return true;
+}
+
+void FaultLog::ProgramEntry(uint32_t addr, const Entry& e)
+{
+    for (uint32_t i = 0; i < ENTRY_HW; i++)
+    {
+        int hw = programOrder[i];
+        flash_program_half_word(addr + hw * 2, ((const uint16_t*)&e)[hw]);
+    }
+}
@@ -0,0 +1,108 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "heatctrl.h"
+
+#define ISCALE      (HEATCTRL_TSCALE * 1000 / HEATCTRL_PERIOD_MS)
+#define WH_UNITS    (3600 * 1000 / HEATCTRL_PERIOD_MS)
+#define MAX_ERR     (100 * HEATCTRL_TSCALE)
+
+int32_t HeatCtrl::kp = 0;
+int32_t HeatCtrl::ki = 0;
+int32_t HeatCtrl::ramp = 0;
+int32_t HeatCtrl::integral = 0;
+int32_t HeatCtrl::power = 0;
+int32_t HeatCtrl::duty = 0;
+uint32_t HeatCtrl::energyWh = 0;
+uint32_t HeatCtrl::energyRest = 0;
+
+void HeatCtrl::SetParams(int32_t p, int32_t i, int32_t r)
+{
+    kp = p;
+    ki = i;
+    ramp = r;
+}
+
+int32_t HeatCtrl::Run(float temp, float target, int32_t maxPower)
+{
+    if (maxPower < 0) maxPower = 0;
+
+    float diff = (target - temp) * HEATCTRL_TSCALE;
+
+    if (diff > MAX_ERR) diff = MAX_ERR;
+    if (diff < -MAX_ERR) diff = -MAX_ERR;
+
+    int32_t err = diff;
+    int32_t newIntegral = integral;
+    int32_t desired = maxPower;
+
+    if (kp != 0 || ki != 0)
+    {
+        newIntegral += ki * err;
+        desired = (kp * err) / HEATCTRL_TSCALE + newIntegral / ISCALE;
+    }
+
+    int32_t limited = Limit(desired, maxPower);
+
+    //Only integrate while that does not push the output further into a limit
+    if (!(limited < desired && err > 0) && !(limited > desired && err < 0))
+        integral = newIntegral;
+
+    if (integral > maxPower * ISCALE) integral = maxPower * ISCALE;
+    if (integral < 0) integral = 0;
+
+    return Output(limited, maxPower);
+}
+
+int32_t HeatCtrl::RunOpenLoop(int32_t maxPower)
+{
+    if (maxPower < 0) maxPower = 0;
+
+    integral = 0;
+    return Output(Limit(maxPower, maxPower), maxPower);
+}
+
+int32_t HeatCtrl::Limit(int32_t desired, int32_t maxPower)
+{
+    int32_t limited = desired;
+
+    if (limited > maxPower) limited = maxPower;
+    if (limited < 0) limited = 0;
+    if (ramp > 0 && limited > power + ramp * HEATCTRL_PERIOD_MS / 1000)
+        limited = power + ramp * HEATCTRL_PERIOD_MS / 1000;
+
+    return limited;
+}
+
+int32_t HeatCtrl::Output(int32_t limited, int32_t maxPower)
+{
+    power = limited;
+    duty = maxPower > 0 ? (power * 100) / maxPower : 0;
+
+    energyRest += power;
+    energyWh += energyRest / WH_UNITS;
+    energyRest %= WH_UNITS;
+
+    return power;
+}
+
+void HeatCtrl::Reset()
+{
+    integral = 0;
+    power = 0;
+    duty = 0;
+}
@@ -25,7 +25,7 @@
 */
 
 #include <hvcu_box.h>
-#include "errormessage.h"
+#include "faultlog.h"
 
 #define RELAY_ON 0x02
 #define RELAY_OFF 0x03
@@ -55,7 +55,7 @@ void HVCU::Task100Ms()
    if (timeoutCounterHVCU > 0) timeoutCounterHVCU--;
    if (timeoutCounterHVCU < 1)
    {
-      ErrorMessage::Post(ERR_HVCU_COMM);
+      FaultLog::Post(ERR_HVCU_COMM);
    }
 }
 
@@ -73,12 +73,12 @@ void HVCU::handle398(uint32_t data[2])  //HVCU Status
 }
 
 
-void HVCU::ControlContactors(int opmode, CanHardware* can)
+void HVCU::ControlContactors(uint8_t contactors, CanHardware* can)
 {
    static int timerCount = 0;
-   static int offTicks = 0; // since opmode went OFF
+   static int offTicks = 0; // since all contactors were opened
 
-   if (opmode != 0 || Param::GetInt(Param::T15Stat) == 1)
+   if (contactors != 0 || Param::GetInt(Param::T15Stat) == 1)
       offTicks = 0;
    else if (offTicks <= 100)
       offTicks++;
@@ -90,45 +90,9 @@ void HVCU::ControlContactors(int opmode, CanHardware* can)
       uint8_t bytes[4];
       bytes[0] = 0x39; // identifier for HVCU
 
-      switch (opmode)
-      {
-         case 0: // Mode off
-            bytes[1]=RELAY_OFF; // precharge relay
-            bytes[2]=RELAY_OFF; // negative relay
-            bytes[3]=RELAY_OFF; // positive relay
-            break;
-
-         case 2: // Mode Precharge
-            bytes[1]=RELAY_ON;  // precharge relay 
-            bytes[2]=RELAY_ON;  // negative relay
-            bytes[3]=RELAY_OFF; // positive relay
-            break;
-
-         case 3: // Mode Precharge fail
-            bytes[1]=RELAY_OFF; // precharge relay 
-            bytes[2]=RELAY_OFF; // negative relay
-            bytes[3]=RELAY_OFF; // positive relay
-            break;
-
-         case 1: // Mode Run
-            //precharge relay stays on incase main contactor drops out with motor running, which could spike voltage and blow up the inverter
-            bytes[1]=RELAY_OFF; // precharge relay
-            bytes[2]=RELAY_ON; // negative relay
-            bytes[3]=RELAY_ON; // positive relay
-            break;
-
-         case 4: // Mode Charge
-            bytes[1]=RELAY_OFF; // precharge relay
-            bytes[2]=RELAY_ON;  // negative relay
-            bytes[3]=RELAY_ON;  // positive relay
-            break;
-
-         case 5: // Shutdown request - HV must stay live, hold contactors closed
-            bytes[1]=RELAY_OFF; // precharge relay
-            bytes[2]=RELAY_ON;  // negative relay
-            bytes[3]=RELAY_ON;  // positive relay
-            break;
-      }
+      bytes[1] = (contactors & ContactorSeq::CT_PRECHARGE) ? RELAY_ON : RELAY_OFF; // precharge relay
+      bytes[2] = (contactors & ContactorSeq::CT_NEGATIVE) ? RELAY_ON : RELAY_OFF;  // negative relay
+      bytes[3] = (contactors & ContactorSeq::CT_MAIN) ? RELAY_ON : RELAY_OFF;      // positive relay
 
       can->Send(0x397, (uint32_t*)bytes,4);
       timerCount = 0; // Reset counter
@@ -26,8 +26,8 @@ DigIo* const IOMatrix::paramToPin[] = { &DigIo::gp_out1, &DigIo::gp_out2, &DigIo
                                         &DigIo::HV_req,&DigIo::gear1_in,&DigIo::gear2_in,&DigIo::gear3_in};
                                         //order of these matters!
 
-AnaIn* const IOMatrix::paramToPinAnalgue[] = {
-   &AnaIn::GP_analog1, &AnaIn::GP_analog2
+AnaFilter* const IOMatrix::paramToPinAnalgue[] = {
+   &AnaFilter::GP_analog1, &AnaFilter::GP_analog2
 };
 
 DigIo* IOMatrix::functionToPin[];
@@ -50,13 +50,13 @@ void IOMatrix::AssignFromParams()
    }
 }
 
-AnaIn* IOMatrix::functionToPinAnalgoue[];
+AnaFilter* IOMatrix::functionToPinAnalgoue[];
 
 void IOMatrix::AssignFromParamsAnalogue()
 {
    for (int i = 0; i < LAST_ANAL; i++)
    {
-      functionToPinAnalgoue[i] = &AnaIn::dummyAnal;
+      functionToPinAnalgoue[i] = &AnaFilter::dummyAnal;
    }
 
    for (int i = 0; i < numAnaloguePins; i++)
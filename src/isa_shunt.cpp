@@ -15,6 +15,7 @@
 #include "my_math.h"
 #include "stm32_can.h"
 #include "params.h"
+#include "sequence.h"
 
 uint16_t  framecount=0;
 bool firstframe=true;
@@ -31,14 +32,68 @@ int32_t ISA::Temperature;
 
 
 
-#define FLASH_DELAY 8000000
-static void delay(void) //delay used for isa setup fumction. probably much better ways but its used only once.......
+#define STEP_DELAY 500 //ms between setup commands, the sensor needs time to store each one
+
+static CanHardware* setupCan;
+
+static void SendStop(int) { ISA::STOP(setupCan); }
+static void SendStore(int) { ISA::sendSTORE(setupCan); }
+static void SendStart(int) { ISA::START(setupCan); }
+
+//Configures result channel 0x520 + arg
+static void SendResultConfig(int arg)
 {
-   int i;
-   for (i = 0; i < FLASH_DELAY; i++)       /* Wait a bit. */
-      __asm__("nop");
+   uint8_t bytes[8];
+
+   bytes[0]=(0x20+arg);
+   bytes[1]=0x42;
+   bytes[2]=0x00;
+   bytes[3]=0x64;
+   bytes[4]=0x00;
+   bytes[5]=0x00;
+   bytes[6]=0x00;
+   bytes[7]=0x00;
+
+   setupCan->Send(0x411, (uint32_t*)bytes, 8);
+}
+
+static void SendCurrentConfig(int)
+{
+   uint8_t bytes[8];
+
+   bytes[0]=0x21;
+   bytes[1]=0x42;
+   bytes[2]=0x01;
+   bytes[3]=0x61;
+   bytes[4]=0x00;
+   bytes[5]=0x00;
+   bytes[6]=0x00;
+   bytes[7]=0x00;
+
+   setupCan->Send(0x411, (uint32_t*)bytes, 8);
 }
 
+#define RESULT_CONFIG(i) { SendResultConfig, i, STEP_DELAY }, { SendStore, 0, STEP_DELAY }
+
+static const Sequence::Step initSteps[] =
+{
+   { SendStop, 0, STEP_DELAY },
+   RESULT_CONFIG(0), RESULT_CONFIG(1), RESULT_CONFIG(2), RESULT_CONFIG(3), RESULT_CONFIG(4),
+   RESULT_CONFIG(5), RESULT_CONFIG(6), RESULT_CONFIG(7), RESULT_CONFIG(8),
+   { SendStart, 0, STEP_DELAY }
+};
+
+static const Sequence::Step initCurrentSteps[] =
+{
+   { SendStop, 0, STEP_DELAY },
+   { SendCurrentConfig, 0, STEP_DELAY },
+   { SendStore, 0, SEQ_PERIOD_MS },
+   { SendStart, 0, STEP_DELAY }
+};
+
+static Sequence initSeq("isainit", SEQUENCE_STEPS(initSteps));
+static Sequence initCurrentSeq("isacurrent", SEQUENCE_STEPS(initCurrentSteps));
+
 void ISA::DecodeCAN(int id, uint32_t data[2])
 {
    switch (id)
@@ -84,31 +139,9 @@ void ISA::RegisterCanMessages(CanHardware* can)
 
 void ISA::initialize(CanHardware* can)
 {
-   uint8_t bytes[8];
-
    firstframe=false;
-   STOP(can);
-   delay();
-   for(int i=0; i<9; i++)
-   {
-      bytes[0]=(0x20+i);
-      bytes[1]=0x42;
-      bytes[2]=0x00;
-      bytes[3]=0x64;
-      bytes[4]=0x00;
-      bytes[5]=0x00;
-      bytes[6]=0x00;
-      bytes[7]=0x00;
-
-      can->Send(0x411, (uint32_t*)bytes, 8);
-      delay();
-
-      sendSTORE(can);
-      delay();
-   }
-   START(can);
-   delay();
-
+   setupCan = can;
+   initSeq.Start();
 }
 
 void ISA::STOP(CanHardware* can)
@@ -204,25 +237,8 @@ void ISA::deFAULT(CanHardware* can)
 
 void ISA::initCurrent(CanHardware* can)
 {
-   uint8_t bytes[8];
-   STOP(can);
-   delay();
-   bytes[0]=0x21;
-   bytes[1]=0x42;
-   bytes[2]=0x01;
-   bytes[3]=0x61;
-   bytes[4]=0x00;
-   bytes[5]=0x00;
-   bytes[6]=0x00;
-   bytes[7]=0x00;
-
-   can->Send(0x411, (uint32_t*)bytes,8);
-
-   delay();
-   sendSTORE(can);
-   START(can);
-   delay();
-
+   setupCan = can;
+   initCurrentSeq.Start();
 }
 
 /********* Private functions *******/
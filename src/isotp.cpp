@@ -0,0 +1,226 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "isotp.h"
+#include <libopencm3/cm3/cortex.h>
+
+#define PCI_SF        0x00
+#define PCI_FF        0x10
+#define PCI_CF        0x20
+#define PCI_FC        0x30
+
+#define FC_CTS        0
+#define FC_WAIT       1
+#define FC_OVFLW      2
+
+IsoTp::IsoTp()
+    : can(0), txId(0), rxLen(0), rxPos(0), rxSn(0), rxTimeout(0), txState(TX_IDLE),
+      txLen(0), txPos(0), txSn(0), blockSize(0), blockCount(0), stMin(0), stMinCount(0), txTimeout(0)
+{
+}
+
+void IsoTp::SetCanInterface(CanHardware* c, uint32_t id)
+{
+    can = c;
+    txId = id;
+}
+
+/* HandleRx() and Send() run in the CAN receive interrupt, Task1Ms() in the
+ * timer interrupt. Either can preempt the other, so each runs its part of
+ * the protocol with interrupts masked.
+ */
+int IsoTp::HandleRx(uint32_t data[2])
+{
+    uint32_t mask = cm_mask_interrupts(1);
+    int len = Receive(data);
+    cm_mask_interrupts(mask);
+    return len;
+}
+
+bool IsoTp::Send(const uint8_t* data, int len)
+{
+    uint32_t mask = cm_mask_interrupts(1);
+    bool result = Transmit(data, len);
+    cm_mask_interrupts(mask);
+    return result;
+}
+
+void IsoTp::Task1Ms()
+{
+    uint32_t mask = cm_mask_interrupts(1);
+
+    if (rxLen > 0 && --rxTimeout == 0)
+        rxLen = 0;
+
+    if (txState == TX_WAIT_FC && --txTimeout == 0)
+        txState = TX_IDLE;
+
+    if (txState == TX_SENDING)
+    {
+        if (stMinCount > 0)
+            stMinCount--;
+        else
+            SendConsecutiveFrame();
+    }
+
+    cm_mask_interrupts(mask);
+}
+
+int IsoTp::Receive(uint32_t data[2])
+{
+    uint8_t* bytes = (uint8_t*)data;
+    int len;
+
+    switch (bytes[0] & 0xF0)
+    {
+    case PCI_SF:
+        len = bytes[0] & 0x0F;
+        if (len == 0 || len > 7) return 0;
+        for (int i = 0; i < len; i++)
+            rxBuf[i] = bytes[i + 1];
+        rxLen = 0;
+        return len;
+    case PCI_FF:
+        rxLen = ((bytes[0] & 0x0F) << 8) | bytes[1];
+        if (rxLen > ISOTP_RX_SIZE)
+        {
+            rxLen = 0;
+            SendFlowControl(FC_OVFLW);
+            return 0;
+        }
+        for (int i = 0; i < 6; i++)
+            rxBuf[i] = bytes[i + 2];
+        rxPos = 6;
+        rxSn = 1;
+        rxTimeout = ISOTP_TIMEOUT_MS;
+        SendFlowControl(FC_CTS);
+        return 0;
+    case PCI_CF:
+        if (rxLen == 0) return 0;
+        if ((bytes[0] & 0x0F) != rxSn)
+        {
+            rxLen = 0; //Lost a frame, drop the message
+            return 0;
+        }
+        rxSn = (rxSn + 1) & 0x0F;
+        rxTimeout = ISOTP_TIMEOUT_MS;
+        for (int i = 1; i < 8 && rxPos < rxLen; i++)
+            rxBuf[rxPos++] = bytes[i];
+        if (rxPos >= rxLen)
+        {
+            len = rxLen;
+            rxLen = 0;
+            return len;
+        }
+        return 0;
+    case PCI_FC:
+        if (txState != TX_WAIT_FC) return 0;
+
+        if ((bytes[0] & 0x0F) == FC_CTS)
+        {
+            blockSize = bytes[1];
+            blockCount = 0;
+            //100-900us STmin values are below our 1ms resolution
+            stMin = bytes[2] <= 0x7F ? bytes[2] : 0;
+            stMinCount = 0;
+            txState = TX_SENDING;
+        }
+        else if ((bytes[0] & 0x0F) == FC_WAIT)
+        {
+            txTimeout = ISOTP_TIMEOUT_MS;
+        }
+        else
+        {
+            txState = TX_IDLE;
+        }
+        return 0;
+    }
+    return 0;
+}
+
+bool IsoTp::Transmit(const uint8_t* data, int len)
+{
+    uint8_t frame[8];
+
+    if (0 == can || len > ISOTP_TX_SIZE) return false;
+
+    //A new response replaces one the tester stopped listening to
+    txState = TX_IDLE;
+
+    for (int i = 0; i < 8; i++)
+        frame[i] = ISOTP_PADDING;
+
+    if (len <= 7)
+    {
+        frame[0] = PCI_SF | len;
+        for (int i = 0; i < len; i++)
+            frame[i + 1] = data[i];
+        SendFrame(frame);
+        return true;
+    }
+
+    for (int i = 0; i < len; i++)
+        txBuf[i] = data[i];
+
+    txLen = len;
+    frame[0] = PCI_FF | (len >> 8);
+    frame[1] = len & 0xFF;
+    for (int i = 0; i < 6; i++)
+        frame[i + 2] = data[i];
+    txPos = 6;
+    txSn = 1;
+    txTimeout = ISOTP_TIMEOUT_MS;
+    txState = TX_WAIT_FC;
+    SendFrame(frame);
+    return true;
+}
+
+void IsoTp::SendConsecutiveFrame()
+{
+    uint8_t frame[8];
+
+    frame[0] = PCI_CF | txSn;
+    for (int i = 1; i < 8; i++)
+        frame[i] = txPos < txLen ? txBuf[txPos++] : ISOTP_PADDING;
+
+    txSn = (txSn + 1) & 0x0F;
+    stMinCount = stMin > 0 ? stMin - 1 : 0;
+    SendFrame(frame);
+
+    if (txPos >= txLen)
+    {
+        txState = TX_IDLE;
+    }
+    else if (blockSize > 0 && ++blockCount >= blockSize)
+    {
+        txTimeout = ISOTP_TIMEOUT_MS;
+        txState = TX_WAIT_FC;
+    }
+}
+
+void IsoTp::SendFlowControl(uint8_t flowStatus)
+{
+    uint8_t frame[8] = { (uint8_t)(PCI_FC | flowStatus), 0, 0, ISOTP_PADDING, ISOTP_PADDING, ISOTP_PADDING, ISOTP_PADDING, ISOTP_PADDING };
+
+    SendFrame(frame); //block size 0 and STmin 0, we take everything at once
+}
+
+void IsoTp::SendFrame(uint8_t* frame)
+{
+    if (0 != can)
+        can->Send(txId, frame, 8);
+}
@@ -0,0 +1,161 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "isrstats.h"
+#include "params.h"
+#include <libopencm3/cm3/scb.h>
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/stm32/rcc.h>
+
+#define ISR_STATS_ENTRY(irq, name) irq,
+static const uint8_t irqs[ISR_STATS_NUM] = { ISR_STATS_LIST };
+#undef ISR_STATS_ENTRY
+#define ISR_STATS_ENTRY(irq, name) name,
+static const char* names[ISR_STATS_NUM] = { ISR_STATS_LIST };
+#undef ISR_STATS_ENTRY
+
+IsrStats::Stats IsrStats::stats[ISR_STATS_NUM];
+void (*IsrStats::handlers[ISR_STATS_NUM])();
+int8_t IsrStats::slot[ISR_STATS_VECTORS];
+volatile uint32_t IsrStats::nestedCycles = 0;
+volatile uint8_t IsrStats::nesting = 0;
+uint32_t IsrStats::vectors[ISR_STATS_VECTORS];
+
+static bool IsCan(uint8_t irq)
+{
+    switch (irq)
+    {
+    case NVIC_USB_LP_CAN_RX0_IRQ:
+    case NVIC_CAN_RX1_IRQ:
+    case NVIC_USB_HP_CAN_TX_IRQ:
+    case NVIC_CAN2_RX0_IRQ:
+    case NVIC_CAN2_RX1_IRQ:
+    case NVIC_CAN2_TX_IRQ:
+    case NVIC_EXTI15_10_IRQ:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void IsrStats::Init()
+{
+    const uint32_t* flashVectors = (const uint32_t*)SCB_VTOR;
+
+    if (!dwt_enable_cycle_counter()) return;
+
+    for (int i = 0; i < ISR_STATS_VECTORS; i++)
+    {
+        vectors[i] = flashVectors[i];
+        slot[i] = -1;
+    }
+
+    for (int i = 0; i < ISR_STATS_NUM; i++)
+    {
+        int exception = 16 + irqs[i];
+
+        handlers[i] = (void (*)())flashVectors[exception];
+        slot[exception] = i;
+        vectors[exception] = (uint32_t)Dispatch;
+    }
+
+    SCB_VTOR = (uint32_t)vectors;
+}
+
+void IsrStats::Update()
+{
+    const uint32_t windowCycles = rcc_ahb_frequency / 10;
+    uint32_t totalLoad = 0, canLoad = 0, maxCycles = 0, maxNesting = 0;
+
+    for (int i = 0; i < ISR_STATS_NUM; i++)
+    {
+        Stats& s = stats[i];
+
+        s.load = ((uint64_t)s.cycles * 1000) / windowCycles;
+        s.totalCycles += s.cycles;
+        s.cycles = 0;
+
+        //The scheduler is already covered by cpuload
+        if (irqs[i] == NVIC_TIM4_IRQ) continue;
+
+        totalLoad += s.load;
+        if (IsCan(irqs[i])) canLoad += s.load;
+        if (s.maxCycles > maxCycles) maxCycles = s.maxCycles;
+        if (s.maxNesting > maxNesting) maxNesting = s.maxNesting;
+    }
+
+    Param::SetFloat(Param::IsrLoad, totalLoad / 10.0f);
+    Param::SetFloat(Param::IsrLoadCan, canLoad / 10.0f);
+    Param::SetInt(Param::IsrMaxTime, maxCycles / (rcc_ahb_frequency / 1000000));
+    Param::SetInt(Param::IsrNest, maxNesting);
+}
+
+void IsrStats::Reset()
+{
+    uint32_t mask = cm_mask_interrupts(1);
+
+    for (int i = 0; i < ISR_STATS_NUM; i++)
+    {
+        stats[i].count = 0;
+        stats[i].cycles = 0;
+        stats[i].maxCycles = 0;
+        stats[i].load = 0;
+        stats[i].totalCycles = 0;
+        stats[i].maxNesting = 0;
+    }
+    cm_mask_interrupts(mask);
+}
+
+void IsrStats::Print(IPutChar* out)
+{
+    uint32_t cyclesPerUs = rcc_ahb_frequency / 1000000;
+
+    fprintf(out, "irq,count,total ms,load pct,max us,nesting\r\n");
+    for (int i = 0; i < ISR_STATS_NUM; i++)
+    {
+        const Stats& s = stats[i];
+
+        fprintf(out, "%s,%u,%u,%u.%u,%u,%u\r\n", names[i], s.count, (uint32_t)(s.totalCycles / (cyclesPerUs * 1000)),
+                s.load / 10, s.load % 10, s.maxCycles / cyclesPerUs, s.maxNesting);
+    }
+}
+
+void IsrStats::Dispatch()
+{
+    int i = slot[SCB_ICSR & SCB_ICSR_VECTACTIVE];
+    uint32_t outerNested = nestedCycles;
+    uint8_t depth = ++nesting;
+
+    nestedCycles = 0;
+    uint32_t start = dwt_read_cycle_counter();
+    handlers[i]();
+    uint32_t elapsed = dwt_read_cycle_counter() - start;
+
+    //Interrupts that preempted this one are accounted to themselves
+    uint32_t mask = cm_mask_interrupts(1);
+    uint32_t own = elapsed - nestedCycles;
+    Stats& s = stats[i];
+
+    nestedCycles = outerNested + elapsed;
+    nesting--;
+    s.count++;
+    s.cycles += own;
+    if (own > s.maxCycles) s.maxCycles = own;
+    if (depth > s.maxNesting) s.maxNesting = depth;
+    cm_mask_interrupts(mask);
+}
@@ -0,0 +1,273 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "linmaster.h"
+#include "hwinit.h"
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/stm32/usart.h>
+
+#define SLOT_TICKS_PER_MS  10 //TIM6 runs at 10kHz
+#define SYNC_BYTE          0x55
+#define DIAG_ID            0x3C //0x3C and 0x3D are diagnostic frames
+
+LinMaster::Frame* LinMaster::frames = 0;
+uint8_t LinMaster::numFrames = 0;
+uint8_t LinMaster::next = 0;
+LinMaster::Frame* LinMaster::active = 0;
+uint8_t LinMaster::pid = 0;
+uint8_t LinMaster::pos = 0;
+uint8_t LinMaster::buf[LIN_MAX_LEN + 1];
+volatile uint8_t LinMaster::state = LinMaster::IDLE;
+bool LinMaster::initialized = false;
+
+void LinMaster::SetSchedule(Frame* f, uint8_t count)
+{
+    if (!initialized) Init();
+
+    //The scheduler outranks both interrupts, keep them out while swapping tables
+    uint32_t mask = cm_mask_interrupts(1);
+
+    timer_disable_counter(TIM6);
+    frames = f;
+    numFrames = f != 0 ? count : 0;
+    next = 0;
+    active = 0;
+    state = IDLE;
+
+    if (numFrames > 0)
+    {
+        timer_set_counter(TIM6, 0);
+        timer_set_period(TIM6, SLOT_TICKS_PER_MS - 1); //first slot starts right away
+        timer_enable_counter(TIM6);
+    }
+    cm_mask_interrupts(mask);
+}
+
+void LinMaster::Write(Frame& frame, const uint8_t* data)
+{
+    uint32_t mask = cm_mask_interrupts(1);
+
+    for (int i = 0; i < frame.len; i++)
+        frame.data[i] = data[i];
+    cm_mask_interrupts(mask);
+}
+
+bool LinMaster::Read(Frame& frame, uint8_t* data)
+{
+    uint32_t mask = cm_mask_interrupts(1);
+    bool fresh = frame.fresh;
+
+    if (fresh)
+    {
+        for (int i = 0; i < frame.len; i++)
+            data[i] = frame.data[i];
+        frame.fresh = false;
+    }
+    cm_mask_interrupts(mask);
+    return fresh;
+}
+
+void LinMaster::Print(IPutChar* out)
+{
+    fprintf(out, "id,dir,ok,no response,checksum,bus\r\n");
+    for (int i = 0; i < numFrames; i++)
+    {
+        const Frame& f = frames[i];
+
+        fprintf(out, "0x%x,%s,%u,%u,%u,%u\r\n", f.id, (f.flags & LIN_PUBLISH) ? "tx" : "rx",
+                f.ok, f.noResponse, f.checksumErrors, f.busErrors);
+    }
+}
+
+void LinMaster::SlotIsr()
+{
+    timer_clear_flag(TIM6, TIM_SR_UIF);
+
+    if (numFrames == 0) return;
+
+    //Whatever did not finish in its slot
+    if (active != 0 && state != DONE && state != FAILED)
+    {
+        if (state == RXDATA && pos == 0)
+            active->noResponse++;
+        else
+            active->busErrors++;
+    }
+
+    Frame& f = frames[next];
+
+    next = (next + 1) % numFrames;
+    active = &f;
+    pid = Pid(f.id);
+    pos = 0;
+
+    if (f.flags & LIN_PUBLISH)
+    {
+        for (int i = 0; i < f.len; i++)
+            buf[i] = f.data[i];
+        buf[f.len] = Checksum(f, buf);
+    }
+
+    timer_set_period(TIM6, f.slotMs * SLOT_TICKS_PER_MS - 1);
+    state = BREAK;
+    USART_CR1(USART1) |= USART_CR1_SBK;
+}
+
+void LinMaster::UsartIsr()
+{
+    uint32_t sr = USART_SR(USART1);
+
+    //The break is received as a 0 with framing error one bit before it is detected,
+    //so handle received data first
+    if (sr & USART_SR_RXNE)
+    {
+        uint8_t data = USART_DR(USART1); //also clears the error flags
+        bool error = sr & (USART_SR_FE | USART_SR_NE | USART_SR_ORE);
+
+        switch (state)
+        {
+        case SYNC:
+            if (error || data != SYNC_BYTE) Fail();
+            else
+            {
+                state = PID;
+                USART_DR(USART1) = pid;
+            }
+            break;
+        case PID:
+            if (error || data != pid) Fail();
+            else if (active->flags & LIN_PUBLISH)
+            {
+                state = TXDATA;
+                USART_DR(USART1) = buf[0];
+            }
+            else
+                state = RXDATA;
+            break;
+        case TXDATA:
+            if (error || data != buf[pos]) Fail();
+            else if (++pos > active->len)
+            {
+                active->ok++;
+                state = DONE;
+            }
+            else
+                USART_DR(USART1) = buf[pos];
+            break;
+        case RXDATA:
+            if (error) Fail();
+            else
+            {
+                buf[pos++] = data;
+
+                if (pos > active->len)
+                {
+                    if (buf[active->len] == Checksum(*active, buf))
+                    {
+                        for (int i = 0; i < active->len; i++)
+                            active->data[i] = buf[i];
+                        active->fresh = true;
+                        active->ok++;
+                        state = DONE;
+                    }
+                    else
+                    {
+                        active->checksumErrors++;
+                        state = FAILED;
+                    }
+                }
+            }
+            break;
+        default: //the break itself or anything after the frame
+            break;
+        }
+    }
+
+    if (sr & USART_SR_LBD)
+    {
+        USART_SR(USART1) = ~USART_SR_LBD; //the other flags ignore writing 1
+
+        if (state == BREAK)
+        {
+            state = SYNC;
+            USART_DR(USART1) = SYNC_BYTE;
+        }
+    }
+}
+
+void LinMaster::Init()
+{
+    usart1_setup();
+    //LIN mode wants one stop bit, no clock output and none of smartcard, half duplex and IrDA
+    USART_CR2(USART1) &= ~(USART_CR2_CLKEN | USART_CR2_STOPBITS_MASK);
+    USART_CR3(USART1) &= ~(USART_CR3_SCEN | USART_CR3_HDSEL | USART_CR3_IREN);
+    USART_CR2(USART1) |= USART_CR2_LINEN | USART_CR2_LBDL | USART_CR2_LBDIE; //11 bit break detection
+    USART_CR1(USART1) |= USART_CR1_RXNEIE;
+
+    rcc_periph_clock_enable(RCC_TIM6);
+    //APB1 is divided, so timers run at twice its frequency
+    timer_set_prescaler(TIM6, (rcc_apb1_frequency * 2) / (SLOT_TICKS_PER_MS * 1000) - 1);
+    timer_enable_irq(TIM6, TIM_DIER_UIE);
+
+    nvic_set_priority(NVIC_USART1_IRQ, 0xe << 4); //a byte takes 520us at 19200, latency doesn't matter
+    nvic_set_priority(NVIC_TIM6_IRQ, 0xe << 4);
+    nvic_enable_irq(NVIC_USART1_IRQ);
+    nvic_enable_irq(NVIC_TIM6_IRQ);
+    initialized = true;
+}
+
+void LinMaster::Fail()
+{
+    active->busErrors++;
+    state = FAILED;
+}
+
+uint8_t LinMaster::Pid(uint8_t id)
+{
+    id &= 0x3F;
+    uint8_t p0 = (id ^ (id >> 1) ^ (id >> 2) ^ (id >> 4)) & 1;
+    uint8_t p1 = ~((id >> 1) ^ (id >> 3) ^ (id >> 4) ^ (id >> 5)) & 1;
+
+    return id | (p0 << 6) | (p1 << 7);
+}
+
+uint8_t LinMaster::Checksum(const Frame& frame, const uint8_t* data)
+{
+    bool classic = (frame.flags & LIN_CLASSIC) || frame.id >= DIAG_ID;
+    uint16_t sum = classic ? 0 : Pid(frame.id);
+
+    for (int i = 0; i < frame.len; i++)
+    {
+        sum += data[i];
+        if (sum > 255) sum -= 255;
+    }
+
+    return ~sum;
+}
+
+extern "C" void tim6_isr(void)
+{
+    LinMaster::SlotIsr();
+}
+
+extern "C" void usart1_isr(void)
+{
+    LinMaster::UsartIsr();
+}
@@ -0,0 +1,203 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lowpower.h"
+#include "hwinit.h"
+#include "hwdefs.h"
+#include "params.h"
+#include "digio.h"
+#include "taskwatchdog.h"
+#include <libopencm3/cm3/scb.h>
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/rtc.h>
+#include <libopencm3/stm32/pwr.h>
+#include <libopencm3/stm32/exti.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/stm32/iwdg.h>
+
+//EXTI5 is either HV_req (PD5) or CAN2 RX (PB5)
+#define EXTI_CAN2_HVREQ  EXTI5
+#define EXTI_T15         EXTI6  //PD6
+#define EXTI_START       EXTI7  //PD7
+#define EXTI_CAN1        EXTI11 //PA11
+#define EXTI_CAN3        EXTI15 //PE15, MCP25625 interrupt
+#define EXTI_RTC_ALARM   EXTI17
+
+uint32_t LowPower::idleTime = 0;
+bool LowPower::requested = false;
+uint32_t LowPower::wakeCycles = 0;
+uint32_t LowPower::wakeUs = 0;
+uint32_t LowPower::rtcCount = 0;
+static bool hvReqLine = false;
+
+void LowPower::Idle(bool idle)
+{
+    uint32_t delay = Param::GetInt(Param::SleepDelay) * 1000;
+
+    if (!idle || delay == 0)
+    {
+        idleTime = 0;
+        requested = false;
+        return;
+    }
+
+    if (idleTime < delay) idleTime += 100;
+    requested = idleTime >= delay;
+}
+
+uint32_t LowPower::Stop(uint32_t wakeIn, bool hvReq, bool can3)
+{
+    uint32_t mask = cm_mask_interrupts(1);
+    uint32_t lines = EXTI_CAN2_HVREQ | EXTI_T15 | EXTI_START | EXTI_CAN1 | EXTI_RTC_ALARM | (can3 ? EXTI_CAN3 : 0);
+    WakeSource source;
+
+    requested = false;
+    idleTime = 0;
+    hvReqLine = hvReq;
+    RtcToLsi();
+    iwdg_set_period_ms(LOWPOWER_IWDG_MS);
+    iwdg_reset();
+
+    //Inputs wake on going active, CAN receive pins on the first dominant bit
+    exti_select_source(EXTI_CAN2_HVREQ, hvReq ? GPIOD : GPIOB);
+    exti_select_source(EXTI_T15, GPIOD);
+    exti_select_source(EXTI_START, GPIOD);
+    exti_select_source(EXTI_CAN1, GPIOA);
+    exti_set_trigger(EXTI_T15 | EXTI_START | EXTI_RTC_ALARM | (hvReq ? EXTI_CAN2_HVREQ : 0), EXTI_TRIGGER_RISING);
+    exti_set_trigger(EXTI_CAN1 | (hvReq ? 0 : EXTI_CAN2_HVREQ), EXTI_TRIGGER_FALLING);
+    //Events only wake the core, nothing runs before the clocks are back
+    EXTI_EMR |= lines;
+
+    rcc_periph_clock_enable(RCC_PWR);
+    PWR_CR = (PWR_CR & ~PWR_CR_PDDS) | PWR_CR_LPDS; //stop with regulator in low power mode
+
+    for (;;)
+    {
+        uint32_t now = rtc_get_counter_val();
+        uint32_t alarm = now + LOWPOWER_FEED_S;
+
+        if (wakeIn != 0 && now >= wakeIn)
+        {
+            source = WAKE_TIMER;
+            break;
+        }
+        if (wakeIn != 0 && alarm > wakeIn) alarm = wakeIn;
+
+        iwdg_reset();
+        source = Sleep(alarm, lines);
+        //Only woke up to feed the watchdog
+        if (source != WAKE_TIMER) break;
+    }
+
+    EXTI_EMR &= ~lines;
+    EXTI_PR = lines;
+    nvic_clear_pending_irq(NVIC_EXTI15_10_IRQ);
+
+    RCC_CLOCK_SETUP();
+    //Up to here we ran on HSI
+    wakeUs = (dwt_read_cycle_counter() - wakeCycles) / 8;
+    wakeCycles = dwt_read_cycle_counter();
+
+    iwdg_set_period_ms(TASKWD_TIMEOUT_MS);
+    iwdg_reset();
+    uint32_t slept = RtcToHse();
+
+    Param::SetInt(Param::WakeSrc, source);
+    Param::SetInt(Param::SleepTime, slept);
+    cm_mask_interrupts(mask);
+
+    return slept;
+}
+
+void LowPower::Resumed()
+{
+    wakeUs += (dwt_read_cycle_counter() - wakeCycles) / (rcc_ahb_frequency / 1000000);
+    Param::SetInt(Param::WakeLatency, wakeUs);
+}
+
+LowPower::WakeSource LowPower::Sleep(uint32_t alarm, uint32_t lines)
+{
+    uint32_t pending;
+
+    rtc_clear_flag(RTC_ALR);
+    rtc_set_alarm_time(alarm);
+    EXTI_PR = lines;
+    PWR_CR |= PWR_CR_CWUF;
+
+    //Clear the event register, anything arriving from now on ends the WFE below
+    __asm__ volatile("sev\n\twfe");
+
+    //An input that is already active has no edge left to wake us
+    if (DigIo::t15_digi.Get()) return WAKE_T15;
+    if (DigIo::start_in.Get()) return WAKE_START;
+    if (hvReqLine && DigIo::HV_req.Get()) return WAKE_HVREQ;
+
+    SCB_SCR |= SCB_SCR_SLEEPDEEP;
+    if ((EXTI_PR & lines) == 0)
+        __asm__ volatile("wfe");
+    SCB_SCR &= ~SCB_SCR_SLEEPDEEP;
+    wakeCycles = dwt_read_cycle_counter();
+
+    pending = EXTI_PR & lines;
+
+    if (pending & EXTI_T15) return WAKE_T15;
+    if (pending & EXTI_START) return WAKE_START;
+    if (pending & EXTI_CAN2_HVREQ) return hvReqLine ? WAKE_HVREQ : WAKE_CAN2;
+    if (pending & EXTI_CAN1) return WAKE_CAN1;
+    if (pending & EXTI_CAN3) return WAKE_CAN3;
+    return WAKE_TIMER;
+}
+
+//Moves the RTC to LSI which keeps running in stop mode. LSI is only accurate
+//to +/-50%, it is measured against the HSE derived core clock first.
+void LowPower::RtcToLsi()
+{
+    rtcCount = rtc_get_counter_val();
+    rtc_interrupt_disable(RTC_SEC);
+
+    //RTCSEL can only be changed after a backup domain reset
+    rcc_backupdomain_reset();
+    rtc_awake_from_off(RCC_LSI);
+    rtc_set_prescale_val(0);
+
+    uint32_t start = rtc_get_counter_val();
+    while (rtc_get_counter_val() == start);
+    uint32_t cycles = dwt_read_cycle_counter();
+    start++;
+    while (rtc_get_counter_val() - start < LOWPOWER_CAL_COUNTS);
+    cycles = dwt_read_cycle_counter() - cycles;
+
+    uint32_t lsiHz = ((uint64_t)rcc_ahb_frequency * LOWPOWER_CAL_COUNTS) / cycles;
+
+    rtc_set_prescale_val(lsiHz - 1);
+    rtc_set_counter_val(0);
+}
+
+//Back to HSE, the counter continues where it was plus the time we slept
+uint32_t LowPower::RtcToHse()
+{
+    uint32_t slept = rtc_get_counter_val();
+
+    rcc_backupdomain_reset();
+    rtc_setup();
+    rtc_set_counter_val(rtcCount + slept);
+
+    return slept;
+}
@@ -0,0 +1,103 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "memstats.h"
+#include "params.h"
+
+//Provided by the libopencm3 linker script
+extern uint32_t _data, _edata, _ebss, end, _stack;
+
+const MemStats::Object* MemStats::objects = 0;
+int MemStats::numObjects = 0;
+uint32_t* MemStats::lowWater = &_stack;
+uint32_t* MemStats::scan = &end;
+
+void __attribute__((noinline)) MemStats::PaintStack()
+{
+    uint32_t marker;
+    //Leave our own and the callers frame alone
+    uint32_t* top = &marker - 16;
+
+    for (uint32_t* p = &end; p < top; p++)
+        *p = MEMSTATS_PATTERN;
+
+    lowWater = top;
+    scan = &end;
+}
+
+void MemStats::SetObjects(const Object* o, int count)
+{
+    objects = o;
+    numObjects = count;
+}
+
+//Checks MEMSTATS_SLICE words per call, a full pass over a mostly unused RAM would hold up the main loop
+void MemStats::Run()
+{
+    uint32_t* p = scan;
+    uint32_t* stop = p + MEMSTATS_SLICE < lowWater ? p + MEMSTATS_SLICE : lowWater;
+
+    while (p < stop && *p == MEMSTATS_PATTERN)
+        p++;
+
+    if (p < stop)
+    {
+        //Lowest overwritten word so far, start over in case the stack reaches further down
+        lowWater = p;
+        scan = &end;
+    }
+    else
+    {
+        scan = p < lowWater ? p : &end;
+    }
+
+    Param::SetInt(Param::StackUsed, (uint32_t)&_stack - (uint32_t)lowWater);
+    Param::SetInt(Param::StackFree, (uint32_t)lowWater - (uint32_t)&end);
+    Param::SetInt(Param::RamStatic, (uint32_t)&_ebss - (uint32_t)&_data);
+}
+
+void MemStats::Print(IPutChar* out)
+{
+    int printed[MEMSTATS_TOP];
+    int numPrinted = 0;
+
+    fprintf(out, "data: %d bytes\r\n", (uint32_t)&_edata - (uint32_t)&_data);
+    fprintf(out, "bss: %d bytes\r\n", (uint32_t)&_ebss - (uint32_t)&_edata);
+    fprintf(out, "stack used: %d bytes\r\n", (uint32_t)&_stack - (uint32_t)lowWater);
+    fprintf(out, "never used: %d bytes\r\n", (uint32_t)lowWater - (uint32_t)&end);
+    fprintf(out, "Largest objects\r\n");
+
+    //Selection by size without modifying the const table
+    while (numPrinted < MEMSTATS_TOP && numPrinted < numObjects)
+    {
+        int largest = -1;
+
+        for (int i = 0; i < numObjects; i++)
+        {
+            bool done = false;
+
+            for (int j = 0; j < numPrinted; j++)
+                done |= printed[j] == i;
+
+            if (!done && (largest < 0 || objects[i].size > objects[largest].size))
+                largest = i;
+        }
+
+        printed[numPrinted++] = largest;
+        fprintf(out, "%s: %d\r\n", objects[largest].name, objects[largest].size);
+    }
+}
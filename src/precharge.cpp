@@ -0,0 +1,147 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "precharge.h"
+#include <math.h>
+
+#define LAG_S ((PCH_LAG * PCH_PERIOD_MS) / 1000.0f)
+
+Precharge::State Precharge::state = Precharge::PCH_IDLE;
+uint32_t Precharge::elapsed = 0;
+float Precharge::samples[PCH_LAG];
+uint8_t Precharge::numSamples = 0;
+uint8_t Precharge::pos = 0;
+float Precharge::start = 0;
+uint16_t Precharge::n = 0;
+float Precharge::meanU = 0;
+float Precharge::meanSlope = 0;
+float Precharge::m2U = 0;
+float Precharge::cUSlope = 0;
+float Precharge::minU = 0;
+float Precharge::maxU = 0;
+float Precharge::tau = 0;
+float Precharge::uFinal = 0;
+
+void Precharge::Start(float udc)
+{
+    state = PCH_RUNNING;
+    start = udc;
+    elapsed = 0;
+    numSamples = 0;
+    pos = 0;
+    n = 0;
+    meanU = 0;
+    meanSlope = 0;
+    m2U = 0;
+    cUSlope = 0;
+    tau = 0;
+    uFinal = 0;
+}
+
+bool Precharge::HasEstimate()
+{
+    float span = maxU - minU;
+
+    return n >= PCH_MIN_POINTS && span >= PCH_MIN_SPAN && uFinal > 0 && span >= PCH_MIN_COVER * (uFinal - minU);
+}
+
+Precharge::State Precharge::Run(float udc, float target, float udcsw, float tol, uint32_t timeoutMs, uint32_t tauMinMs)
+{
+    if (state != PCH_RUNNING) return state;
+
+    elapsed += PCH_PERIOD_MS;
+    Fit(udc);
+
+    //Within one period an RC with tauMinMs gets this fraction of the way
+    if (elapsed == PCH_PERIOD_MS && tauMinMs > 0 && target > start + tol &&
+        (udc - start) > (target - start) * (1 - expf(-(float)PCH_PERIOD_MS / tauMinMs)))
+    {
+        state = PCH_FAILFAST;
+        return state;
+    }
+
+    bool estimate = HasEstimate();
+    bool known = target > 0;
+    //A curve that hasn't risen needs no fit, the capacitors were still charged
+    bool risen = (udc - start) > tol;
+    //Voltage at which we will be done and the time the curve needs to get there
+    float doneU = known ? target - tol : udcsw;
+    float timeLeft = uFinal > doneU && udc < doneU ? tau * logf((uFinal - udc) / (uFinal - doneU)) : 0;
+
+    if (estimate && tauMinMs > 0 && tau < tauMinMs)
+        state = PCH_FAILFAST;
+    else if (estimate && uFinal < (known ? target : udcsw) * PCH_LOAD_RATIO)
+        state = PCH_FAILLOAD;
+    else if ((estimate || !risen || !known) && udc >= doneU)
+        state = PCH_DONE;
+    else if (elapsed >= timeoutMs)
+        state = PCH_FAILSLOW;
+    else if (estimate && udc < doneU && (elapsed + timeLeft) > timeoutMs)
+        state = PCH_FAILSLOW;
+
+    return state;
+}
+
+void Precharge::Fit(float udc)
+{
+    float old = samples[pos];
+
+    samples[pos] = udc;
+    pos = (pos + 1) % PCH_LAG;
+
+    if (numSamples < PCH_LAG)
+    {
+        numSamples++;
+        return;
+    }
+
+    //Secant over the last PCH_LAG samples, placed at the mean of its end points
+    float u = (udc + old) / 2;
+    float slope = (udc - old) / LAG_S;
+
+    if (n == 0)
+    {
+        minU = u;
+        maxU = u;
+    }
+    minU = u < minU ? u : minU;
+    maxU = u > maxU ? u : maxU;
+
+    //Welford, sums of squares lose too much precision in single float
+    n++;
+    float du = u - meanU;
+    meanU += du / n;
+    meanSlope += (slope - meanSlope) / n;
+    m2U += du * (u - meanU);
+    cUSlope += du * (slope - meanSlope);
+
+    if (n < 2 || m2U <= 0) return;
+
+    //slope = b * (uFinal - u)
+    float b = -cUSlope / m2U;
+
+    if (b <= 0)
+    {
+        uFinal = 0;
+        return;
+    }
+
+    uFinal = meanU + meanSlope / b;
+    //A secant of an exponential over the lag L has b = 2/L * tanh(L / (2 * tau))
+    float x = b * LAG_S / 2;
+    tau = x < 1 ? 1000 * LAG_S / (2 * atanhf(x)) : 0;
+}
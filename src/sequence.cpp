@@ -0,0 +1,79 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sequence.h"
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/stm32/rcc.h>
+
+Sequence* Sequence::first = 0;
+
+Sequence::Sequence(const char* n, const Step* s, uint8_t num)
+    : name(n), steps(s), numSteps(num), pos(0), delay(0), running(false), listed(false), runs(0), maxCycles(0), next(0)
+{
+}
+
+void Sequence::Start()
+{
+    //Only sequences that were ever used show up in the list
+    if (!listed)
+    {
+        next = first;
+        first = this;
+        listed = true;
+    }
+
+    dwt_enable_cycle_counter();
+    running = false;
+    pos = 0;
+    delay = 0;
+    runs++;
+    running = true;
+}
+
+void Sequence::RunAll()
+{
+    for (Sequence* s = first; s != 0; s = s->next)
+        s->Run();
+}
+
+void Sequence::Run()
+{
+    if (!running) return;
+    if (delay > 0 && --delay > 0) return;
+
+    const Step& step = steps[pos];
+    uint32_t start = dwt_read_cycle_counter();
+
+    step.action(step.arg);
+
+    uint32_t elapsed = dwt_read_cycle_counter() - start;
+
+    if (elapsed > maxCycles) maxCycles = elapsed;
+
+    delay = step.waitMs / SEQ_PERIOD_MS;
+    pos++;
+    if (pos >= numSteps) running = false;
+}
+
+void Sequence::Print(IPutChar* out)
+{
+    uint32_t cyclesPerUs = rcc_ahb_frequency / 1000000;
+
+    fprintf(out, "sequence,running,step,starts,max us\r\n");
+    for (Sequence* s = first; s != 0; s = s->next)
+        fprintf(out, "%s,%u,%u,%u,%u\r\n", s->name, s->running, s->pos, s->runs, s->maxCycles / cyclesPerUs);
+}
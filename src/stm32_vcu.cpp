@@ -95,7 +95,6 @@
 #include "CPC.h"
 #include "Foccci.h"
 #include "NoInverter.h"
-#include "linbus.h"
 #include "VWheater.h"
 #include "ElconCharger.h"
 #include "rearoutlanderinverter.h"
@@ -107,6 +106,24 @@
 #include "EvControlsT2C.h"
 #include "DilithiumMCU.h"
 #include "hvcu_box.h"
+#include "blackbox.h"
+#include "faultlog.h"
+#include "taskwatchdog.h"
+#include "isrstats.h"
+#include "memstats.h"
+#include "bootprofile.h"
+#include "precharge.h"
+#include "contactorseq.h"
+#include "lowpower.h"
+#include "Preheater.h"
+#include "heatctrl.h"
+#include "sequence.h"
+#include "anafilter.h"
+#include "drivers.h"
+#include "deviceslot.h"
+#include "fixeddevice.h"
+#include "bulksdo.h"
+#include "canmapscheduler.h"
 
 #define PRINT_JSON 0
 
@@ -122,6 +139,7 @@ static bool chargeModeDC = false;
 static bool ChgLck = false;
 static CanHardware* canInterface[3];
 static CanMap* canMap;
+static CanMapScheduler* canMapScheduler;
 static ChargeModes targetCharger;
 static ChargeInterfaces targetChgint;
 static uint8_t ChgSet;  // Temp variable storing Param::Chgctrl. 0=enable, 1=disable, 2=timer.
@@ -135,79 +153,315 @@ static bool ACrequest=false;
 static bool initbyStart=false;
 static bool initbyCharge=false;
 static bool OutlanderCAN=false;
+static bool chgForPreHeat=false;
+static Preheater preHeater;
+static bool cabHeating = false;
 
 static volatile unsigned
 days=0,
 hours=0, minutes=0, seconds=0,
 alarm=0;			// != 0 when alarm is pending
 
-static uint16_t rlyDly=25;
-static uint16_t shutdownReq=0;//HV-device wind-down timer (10ms ticks) held in MOD_SHUTDOWN_REQUEST before contactors open
+static uint16_t t15Hold = 0; //T15ON off-delay, 10ms ticks
+static ContactorSeq localContactors(ContactorSeq::TOP_LOCAL);
+static ContactorSeq boxContactors(ContactorSeq::TOP_SBOX);
 
 // Instantiate Classes
-static BMW_E31 e31Vehicle;
-static BMW_E65 e65Vehicle;
-static BMW_E90 e90Vehicle;
-static BMW_E39 e39Vehicle;
-static Can_VAG vagVehicle;
-static SubaruVehicle subaruVehicle;
-static GS450HClass gs450Inverter;
-static LeafINV leafInv;
-static NissanPDM chargerPDM;
-static teslaCharger ChargerTesla;
-static ElconCharger ChargerElcon;
+// Only one device per category is ever used, it is constructed in its slot by the Update functions.
+// The "none" devices stay static, they are selected while a slot is being rebuilt
+// and until ReconfigureDevices() built the selected ones at boot.
+// Categories the build profile hardwires (FIXED_xx) use a FixedDevice instead.
+#ifdef FIXED_VEHICLE
+static FixedDevice<Vehicle, FIXED_VEHICLE, FIXED_VEHICLE_SEL> vehicleSlot;
+#else
+static DeviceSlot<Vehicle, NoVehicle
+#ifdef DRV_E31
+                  , BMW_E31
+#endif
+#ifdef DRV_E65
+                  , BMW_E65
+#endif
+#ifdef DRV_E90
+                  , BMW_E90
+#endif
+#ifdef DRV_E39
+                  , BMW_E39
+#endif
+#ifdef DRV_VAG
+                  , Can_VAG
+#endif
+#ifdef DRV_SUBARU
+                  , SubaruVehicle
+#endif
+#ifdef DRV_CLASSIC
+                  , V_Classic
+#endif
+                  > vehicleSlot;
+#endif
+#ifdef FIXED_INVERTER
+static FixedDevice<Inverter, FIXED_INVERTER, FIXED_INVERTER_SEL> inverterSlot;
+#else
+static DeviceSlot<Inverter, NoInverterClass
+#ifdef DRV_GS450H
+                  , GS450HClass
+#endif
+#ifdef DRV_LEAFINV
+                  , LeafINV
+#endif
+#ifdef DRV_OPENINV
+                  , Can_OI
+#endif
+#ifdef DRV_OUTLANDERINV
+                  , OutlanderInverter
+#endif
+#ifdef DRV_REAROUTLANDERINV
+                  , RearOutlanderInverter
+#endif
+#ifdef DRV_T2C
+                  , EvControlsT2C
+#endif
+                  > inverterSlot;
+#endif
+#ifdef FIXED_CHARGER
+static FixedDevice<Chargerhw, FIXED_CHARGER, FIXED_CHARGER_SEL> chargerSlot;
+#else
+static DeviceSlot<Chargerhw, noCharger
+#ifdef DRV_NISSANPDM
+                  , NissanPDM
+#endif
+#ifdef DRV_TESLACHARGER
+                  , teslaCharger
+#endif
+#ifdef DRV_ELCON
+                  , ElconCharger
+#endif
+#ifdef DRV_EXTCHARGER
+                  , extCharger
+#endif
+#ifdef DRV_AMPERACHARGER
+                  , amperaCharger
+#endif
+#ifdef DRV_OUTLANDERCHARGER
+                  , outlanderCharger
+#endif
+                  > chargerSlot;
+#endif
+#ifdef FIXED_CHARGEINT
+static FixedDevice<Chargerint, FIXED_CHARGEINT, FIXED_CHARGEINT_SEL> chargeIntSlot;
+#else
+static DeviceSlot<Chargerint, notused
+#ifdef DRV_CHADEMO
+                  , FCChademo
+#endif
+#ifdef DRV_I3LIM
+                  , i3LIMClass
+#endif
+#ifdef DRV_CPC
+                  , CPCClass
+#endif
+#ifdef DRV_FOCCCI
+                  , FoccciClass
+#endif
+                  > chargeIntSlot;
+#endif
+#ifdef FIXED_HEATER
+static FixedDevice<Heater, FIXED_HEATER, FIXED_HEATER_SEL> heaterSlot;
+#else
+static DeviceSlot<Heater, noHeater
+#ifdef DRV_AMPERAHEATER
+                  , AmperaHeater
+#endif
+#ifdef DRV_OUTLANDERHEATER
+                  , OutlanderCanHeater
+#endif
+#ifdef DRV_VWHEATER
+                  , vwHeater
+#endif
+                  > heaterSlot;
+#endif
+#ifdef FIXED_SHIFTER
+static FixedDevice<Shifter, FIXED_SHIFTER, FIXED_SHIFTER_SEL> shifterSlot;
+#else
+static DeviceSlot<Shifter, no_Lever
+#ifdef DRV_F30LEVER
+                  , F30_Lever
+#endif
+#ifdef DRV_E65LEVER
+                  , E65_Lever
+#endif
+#ifdef DRV_JLRG1
+                  , JLR_G1
+#endif
+#ifdef DRV_JLRG2
+                  , JLR_G2
+#endif
+                  > shifterSlot;
+#endif
+#ifdef FIXED_BMS
+static FixedDevice<BMS, FIXED_BMS, FIXED_BMS_SEL> bmsSlot;
+#else
+static DeviceSlot<BMS, BMS
+#ifdef DRV_SIMPBMS
+                  , SimpBMS
+#endif
+#ifdef DRV_LEAFBMS
+                  , LeafBMS
+#endif
+#ifdef DRV_DAISYCHAIN
+                  , DaisychainBMS
+#endif
+#ifdef DRV_KANGOOBMS
+                  , KangooBMS
+#endif
+#ifdef DRV_DILITHIUM
+                  , DilithiumMCU
+#endif
+                  > bmsSlot;
+#endif
+#ifdef FIXED_DCDC
+static FixedDevice<DCDC, FIXED_DCDC, FIXED_DCDC_SEL> dcdcSlot;
+#else
+static DeviceSlot<DCDC, DCDC
+#ifdef DRV_TESLADCDC
+                  , TeslaDCDC
+#endif
+                  > dcdcSlot;
+#endif
 static notused UnUsed;
 static noCharger nochg;
-static extCharger chgdigi;
-static amperaCharger ampChg;
-static outlanderCharger outChg;
-static FCChademo chademoFC;
-static i3LIMClass LIMFC;
-static CPCClass CPCcan;
-static FoccciClass Focccican;
-static Can_OI openInv;
 static NoInverterClass NoInverter;
-static OutlanderInverter outlanderInv;
 static noHeater Heaternone;
-static AmperaHeater amperaHeater;
-static OutlanderCanHeater outlanderCanHeater;
 static no_Lever NoGearLever;
-static F30_Lever F30GearLever;
-static E65_Lever E65GearLever;
-static JLR_G1 JLRG1shift;
-static JLR_G2 JLRG2shift;
-static vwHeater heaterVW;
 static NoVehicle VehicleNone;
-static V_Classic classVehicle;
-static Inverter* selectedInverter = &openInv;
+#ifdef FIXED_INVERTER
+static FixedDevice<Inverter, FIXED_INVERTER, FIXED_INVERTER_SEL>& selectedInverter = inverterSlot;
+#else
+static Inverter* selectedInverter = &NoInverter;
+#endif
+#ifdef FIXED_VEHICLE
+static FixedDevice<Vehicle, FIXED_VEHICLE, FIXED_VEHICLE_SEL>& selectedVehicle = vehicleSlot;
+#else
 static Vehicle* selectedVehicle = &VehicleNone;
+#endif
+#ifdef FIXED_HEATER
+static FixedDevice<Heater, FIXED_HEATER, FIXED_HEATER_SEL>& selectedHeater = heaterSlot;
+#else
 static Heater* selectedHeater = &Heaternone;
-static Chargerhw* selectedCharger = &chargerPDM;
+#endif
+#ifdef FIXED_CHARGER
+static FixedDevice<Chargerhw, FIXED_CHARGER, FIXED_CHARGER_SEL>& selectedCharger = chargerSlot;
+#else
+static Chargerhw* selectedCharger = &nochg;
+#endif
+#ifdef FIXED_CHARGEINT
+static FixedDevice<Chargerint, FIXED_CHARGEINT, FIXED_CHARGEINT_SEL>& selectedChargeInt = chargeIntSlot;
+#else
 static Chargerint* selectedChargeInt = &UnUsed;
+#endif
+#ifdef FIXED_SHIFTER
+static FixedDevice<Shifter, FIXED_SHIFTER, FIXED_SHIFTER_SEL>& selectedShifter = shifterSlot;
+#else
 static Shifter* selectedShifter = &NoGearLever;
+#endif
 static BMS BMSnone;
-static SimpBMS BMSsimp;
-static LeafBMS BMSleaf;
-static DaisychainBMS BMSdaisychain;
-static KangooBMS BMSRenaultKangoo33;
-static DilithiumMCU BMSDilithium;
 static DCDC DCDCnone;
-static TeslaDCDC DCDCTesla;
+#ifdef FIXED_BMS
+static FixedDevice<BMS, FIXED_BMS, FIXED_BMS_SEL>& selectedBMS = bmsSlot;
+#else
 static BMS* selectedBMS = &BMSnone;
+#endif
+#ifdef FIXED_DCDC
+static FixedDevice<DCDC, FIXED_DCDC, FIXED_DCDC_SEL>& selectedDCDC = dcdcSlot;
+#else
 static DCDC* selectedDCDC = &DCDCnone;
+#endif
 static Can_OBD2 canOBD2;
-static Shifter shifterNone;
-static RearOutlanderInverter rearoutlanderInv;
-static EvControlsT2C evControlsT2C;
-static LinBus* lin;
+static bool can3Enabled = false;
+static volatile bool digiPotsReady = false;
+
+//Device slots are the bulk of .bss, listed by the "mem" command
+#define MEM_OBJECT(o) { #o, sizeof(o) },
+static const MemStats::Object staticObjects[] =
+{
+    MEM_OBJECT(vehicleSlot) MEM_OBJECT(inverterSlot) MEM_OBJECT(chargerSlot) MEM_OBJECT(chargeIntSlot)
+    MEM_OBJECT(heaterSlot) MEM_OBJECT(shifterSlot) MEM_OBJECT(bmsSlot) MEM_OBJECT(dcdcSlot)
+    MEM_OBJECT(canOBD2)
+};
+#undef MEM_OBJECT
+
+//HV_req shares its wake up line with CAN2, it only gets it when a function uses it
+static bool HvReqAssigned()
+{
+    for (int i = 0; i < IOMatrix::LAST; i++)
+    {
+        if (IOMatrix::GetPin((IOMatrix::pinfuncs)i) == &DigIo::HV_req) return true;
+    }
+    return false;
+}
+
+//Seconds until the charge or preheat timer starts, 0 if neither will
+static uint32_t TimerDelay()
+{
+    uint32_t delay = preHeater.GetStartDelay(hours, minutes, seconds);
+
+    if (ChgSet == 2 && !ChgLck && ChgDur_tmp != 0)
+    {
+        uint32_t now = (hours * 60 + minutes) * 60 + seconds;
+        uint32_t start = (ChgHrs_tmp * 60 + ChgMins_tmp) * 60;
+        uint32_t chgDelay = (start + 86400 - now) % 86400;
+
+        if (chgDelay == 0) chgDelay = 86400;
+        if (delay == 0 || chgDelay < delay) delay = chgDelay;
+    }
+    return delay;
+}
+
+//rtc_isr doesn't run in stop mode, catch up on the time we slept
+static void AdvanceClock(uint32_t s)
+{
+    s += seconds + 60 * (minutes + 60 * (hours + 24 * days));
+    seconds = s % 60;
+    s /= 60;
+    minutes = s % 60;
+    s /= 60;
+    hours = s % 24;
+    days = s / 24;
+}
+
+//Transceivers go to standby, everything comes back like it was before
+static void Sleep()
+{
+    bool linAwake = DigIo::lin_nslp.Get();
+    bool mcpAwake = !DigIo::mcp_sby.Get();
+
+    if (can3Enabled) CANSPI_Sleep();
+    DigIo::mcp_sby.Set();
+    DigIo::lin_nslp.Clear();
+
+    uint32_t slept = LowPower::Stop(TimerDelay(), HvReqAssigned(), can3Enabled);
+
+    rtc_interrupt_disable(RTC_SEC);
+    AdvanceClock(slept);
+    rtc_interrupt_enable(RTC_SEC);
+
+    if (linAwake) DigIo::lin_nslp.Set();
+    if (mcpAwake) DigIo::mcp_sby.Clear();
+    if (can3Enabled)
+    {
+        CANSPI_Initialize();
+        CANSPI_ENRx_IRQ();
+    }
+    LowPower::Resumed();
+}
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 static void Ms200Task(void)
 {
+    TaskWatchdog::Enter(TaskWatchdog::TASK_200MS);
     int opmode = Param::GetInt(Param::opmode);
 
-    selectedVehicle->Task200Ms();
-    if(opmode==MOD_CHARGE) selectedCharger->Task200Ms();
+    if (vehicleSlot.Has(DEVTASK_200MS)) selectedVehicle->Task200Ms();
+    if(opmode==MOD_CHARGE && chargerSlot.Has(DEVTASK_200MS)) selectedCharger->Task200Ms();
 
     //if(opmode==MOD_CHARGE) utils::CpSpoofOutput;
     utils::CpSpoofOutput();
@@ -250,6 +504,20 @@ static void Ms200Task(void)
     if(ChgSet==0 && !ChgLck) RunChg=true;//enable from webui if we are not locked out from an auto termination
     if(ChgSet==1) RunChg=false;//disable from webui
 
+    //While preheating let a plugged in charger run so the heater draws from the EVSE, not the pack.
+    //This counts against the charge timer duration.
+    preHeater.Task200Ms(opmode, hours, minutes, selectedHeater->HasTemperature());
+    if(preHeater.GetRunPreHeat() && ChgSet==2 && !ChgLck)
+    {
+        RunChg=true;
+        chgForPreHeat=true;
+    }
+    else if(chgForPreHeat)
+    {
+        chgForPreHeat=false;
+        RunChg=false;
+    }
+
     //Handle PP on the Charging port
     if(Param::GetInt(Param::GPA1Func) == IOMatrix::PILOT_PROX || Param::GetInt(Param::GPA2Func) == IOMatrix::PILOT_PROX )
     {
@@ -371,15 +639,19 @@ static void Ms200Task(void)
     {
         IOMatrix::GetPin(IOMatrix::BRAKEVACPUMP)->Clear();
     }
+    TaskWatchdog::Leave();
 }
 
 static void Ms100Task(void)
 {
+    TaskWatchdog::Enter(TaskWatchdog::TASK_100MS);
     DigIo::led_out.Toggle();
-    iwdg_reset();
+    TaskWatchdog::Feed();
     float cpuLoad = scheduler->GetCpuLoad() / 10.0f;
     Param::SetFloat(Param::cpuload, cpuLoad);
+    IsrStats::Update();
     Param::SetInt(Param::lasterr, ErrorMessage::GetLastError());
+    FaultLog::Task100Ms();
     int opmode = Param::GetInt(Param::opmode);
     utils::SelectDirection(selectedVehicle, selectedShifter);
 
@@ -393,16 +665,26 @@ static void Ms100Task(void)
 
     utils::ProcessCruiseControlButtons();
 
-    selectedInverter->Task100Ms();
-    selectedVehicle->Task100Ms();
-    selectedCharger->Task100Ms();
-    selectedBMS->Task100Ms();
-    selectedDCDC->Task100Ms();
-    selectedShifter->Task100Ms();
-    selectedHeater->Task100Ms();
-    canMap->SendAll();
+    if (inverterSlot.Has(DEVTASK_100MS)) selectedInverter->Task100Ms();
+    if (vehicleSlot.Has(DEVTASK_100MS)) selectedVehicle->Task100Ms();
+    if (chargerSlot.Has(DEVTASK_100MS)) selectedCharger->Task100Ms();
+    if (bmsSlot.Has(DEVTASK_100MS)) selectedBMS->Task100Ms();
+    if (dcdcSlot.Has(DEVTASK_100MS)) selectedDCDC->Task100Ms();
+    if (shifterSlot.Has(DEVTASK_100MS)) selectedShifter->Task100Ms();
+    if (heaterSlot.Has(DEVTASK_100MS)) selectedHeater->Task100Ms();
     HVCU::Task100Ms();
 
+    //Without a tmpheater source the loop can't be closed, e.g. the Ampera heater
+    if (cabHeating && selectedHeater->HasTemperature())
+        HeatCtrl::Run(selectedHeater->GetTemperature(), Param::GetInt(Param::HeatTargetTemp), Param::GetInt(Param::HeatPwr));
+    else if (cabHeating)
+        HeatCtrl::RunOpenLoop(Param::GetInt(Param::HeatPwr));
+    else
+        HeatCtrl::Reset();
+
+    Param::SetInt(Param::HeatDuty, HeatCtrl::GetDuty());
+    Param::SetFloat(Param::HeatEnergy, HeatCtrl::GetEnergy() / 1000.0f);
+
     if(OutlanderCAN == true)
     {
         OutlanderHeartBeat::Task100Ms();
@@ -480,8 +762,11 @@ static void Ms100Task(void)
         Param::SetInt(Param::HeatReq,IOMatrix::GetPin(IOMatrix::HEATREQ)->Get());
     }
 
-    DigiPot::SetPot1Step(); //just for dev
-    DigiPot::SetPot2Step(); //just for dev
+    if (digiPotsReady)
+    {
+        DigiPot::SetPot1Step(); //just for dev
+        DigiPot::SetPot2Step(); //just for dev
+    }
 
     //Cooling Fan Control//
     if(opmode==MOD_CHARGE || opmode==MOD_RUN)
@@ -524,57 +809,89 @@ static void Ms100Task(void)
         }
 
         if (burst_count > 0) {
-            evControlsT2C.setGear();
+#ifdef DRV_T2C
+            EvControlsT2C* t2c = inverterSlot.Get<EvControlsT2C>();
+            if (t2c) t2c->setGear();
+#endif
             burst_count--;
         }
     }
+
+    LowPower::Idle(opmode == MOD_OFF && t15Hold == 0 && !chargeMode && !chargeModeDC && !preHeater.GetRunPreHeat() && !selectedVehicle->Ready() &&
+                   !DigIo::start_in.Get() && !(HvReqAssigned() && DigIo::HV_req.Get()));
+    TaskWatchdog::Leave();
+}
+
+//Current must have stayed below ShdnIdc for ShdnDebounce before contactors may open
+static uint8_t ContactorConditions(float idc)
+{
+    static uint16_t idcLowTime = 0;
+    uint8_t cond = ContactorSeq::CTC_NONE;
+
+    if (ABS(idc) >= Param::GetFloat(Param::ShdnIdc))
+        idcLowTime = 0;
+    else if (idcLowTime < Param::GetInt(Param::ShdnDebounce))
+        idcLowTime += CTS_PERIOD_MS;
+    else
+        cond |= ContactorSeq::CTC_CURRENT_LOW;
+
+    if (selectedCharger->IsIdle() && selectedDCDC->IsIdle() && selectedHeater->IsIdle())
+        cond |= ContactorSeq::CTC_DEVICES_IDLE;
+
+    return cond;
 }
 
 static void ControlCabHeater(int opmode)
 {
-    //Only run heater in run mode
-    //What about charge mode and timer mode?
-    if (opmode == MOD_RUN && (Param::GetInt(Param::Control) == 1 || Param::GetBool(Param::HeatReq)))
+    //Run heater in run mode when enabled or requested, and while preheating once HV is up
+    bool preheat = preHeater.GetHeatDemand() && (opmode == MOD_RUN || opmode == MOD_CHARGE);
+
+    if (preheat || (opmode == MOD_RUN && (Param::GetInt(Param::Control) == 1 || Param::GetBool(Param::HeatReq))))
     {
         IOMatrix::GetPin(IOMatrix::HEATERENABLE)->Set();//Heater enable and coolant pump on
         selectedHeater->SetTargetTemperature(Param::GetInt(Param::HeatTargetTemp));
-        selectedHeater->SetPower(Param::GetInt(Param::HeatPwr), true);
+        selectedHeater->SetPower(HeatCtrl::GetPower(), true);//Modulated by the 100ms task
+        cabHeating = true;
     }
     else
     {
         IOMatrix::GetPin(IOMatrix::HEATERENABLE)->Clear(); //Disable heater and coolant pump
         selectedHeater->SetPower(0, false);
+        cabHeating = false;
     }
 }
 
 static void Ms10Task(void)
 {
+    TaskWatchdog::Enter(TaskWatchdog::TASK_10MS);
     static uint32_t vehicleStartTime = 0;
+    TickParams t;
 
-    int16_t previousSpeed=Param::GetInt(Param::speed);
+    t.Load();
+    int16_t previousSpeed = t.speed;
     int16_t speed = 0;
     float torquePercent;
-    int opmode = Param::GetInt(Param::opmode);
+    int opmode = t.opmode;
     int stt = STAT_NONE;
-    int requestedDirection = Param::GetInt(Param::dir);
+    int requestedDirection = t.dir;
     int rollingDirection = 0;
 
     ErrorMessage::SetTime(rtc_get_counter_val());
 
-    selectedChargeInt->Task10Ms();
+    if (chargeIntSlot.Has(DEVTASK_10MS)) selectedChargeInt->Task10Ms();
 
-    if (Param::GetInt(Param::opmode) == MOD_RUN) //!!!THROTTLE CODE HERE//
+    if (opmode == MOD_RUN) //!!!THROTTLE CODE HERE//
     {
-        torquePercent = utils::ProcessThrottle(ABS(previousSpeed)); //run the throttle reading and checks and then generate Potnom
+        torquePercent = utils::ProcessThrottle(t); //run the throttle reading and checks and then generate Potnom
 
 
         //When requesting regen we need to be careful. If the car is not rolling
         //in the same direction as the selected gear, we will actually accelerate!
         //Exclude openinverter here because that has its own regen logic
 
-        if (torquePercent < 0 && Param::GetInt(Param::Inverter) != InvModes::OpenI)
+        if (torquePercent < 0 && t.inverter != InvModes::OpenI)
         {
-            if(Param::GetInt(Param::reversemotor) == 0)
+            if(t.reverseMotor == 0)
             {
                 rollingDirection = previousSpeed >= 0 ? 1 : -1;
             }
@@ -592,7 +909,7 @@ static void Ms10Task(void)
 
         torquePercent *= requestedDirection; //torque requests invert when reverse direction is selected
 
-        selectedInverter->Task10Ms();
+        if (inverterSlot.Has(DEVTASK_10MS)) selectedInverter->Task10Ms();
     }
     else
     {
@@ -617,7 +934,7 @@ static void Ms10Task(void)
     //speed = ABS(selectedInverter->GetMotorSpeed());//set motor rpm on interface NO ABS allowed on speed as we need to know direction
     speed = selectedInverter->GetMotorSpeed();//set motor rpm on interface
 
-    Param::SetInt(Param::speed, speed);
+    t.SetSpeed(speed);
     utils::GetDigInputs(canInterface[Param::GetInt(Param::InverterCan)]);
 
     if(opmode==MOD_RUN || opmode==MOD_CHARGE) //only set rev counter when in RUN or CHARGE
@@ -625,16 +942,16 @@ static void Ms10Task(void)
         selectedVehicle->SetRevCounter(ABS(speed)); //ABS allowed here to keep number from rolling over.
     }
     selectedVehicle->SetTemperatureGauge(Param::GetFloat(Param::tmphs));
-    selectedVehicle->Task10Ms();
-    selectedDCDC->Task10Ms();
-    selectedShifter->Task10Ms();
+    if (vehicleSlot.Has(DEVTASK_10MS)) selectedVehicle->Task10Ms();
+    if (dcdcSlot.Has(DEVTASK_10MS)) selectedDCDC->Task10Ms();
+    if (shifterSlot.Has(DEVTASK_10MS)) selectedShifter->Task10Ms();
     if(opmode==MOD_CHARGE)
     {
-        selectedCharger->Task10Ms();
+        if (chargerSlot.Has(DEVTASK_10MS)) selectedCharger->Task10Ms();
     }
     else if (Param::GetInt(Param::chargemodes) == ChargeModes::Leaf_PDM)
     {
-        selectedCharger->Task10Ms();
+        if (chargerSlot.Has(DEVTASK_10MS)) selectedCharger->Task10Ms();
     }
     if(opmode==MOD_RUN) Param::SetInt(Param::canctr, (Param::GetInt(Param::canctr) + 1) & 0xF);//Update the OI can counter in RUN mode only
 
@@ -646,34 +963,43 @@ static void Ms10Task(void)
     //            MODE CONTROL SECTION              //
     //////////////////////////////////////////////////
 
-    float udc = utils::ProcessUdc(speed);
+    float udc = utils::ProcessUdc(t);
     stt |= Param::GetInt(Param::pot) <= Param::GetInt(Param::potmin) ? STAT_NONE : STAT_POTPRESSED;
     stt |= udc >= Param::GetFloat(Param::udcsw) ? STAT_NONE : STAT_UDCBELOWUDCSW;
-    stt |= udc < Param::GetFloat(Param::udclim) ? STAT_NONE : STAT_UDCLIM;
+    stt |= udc < t.udclim ? STAT_NONE : STAT_UDCLIM;
     stt |= Param::GetFloat(Param::udc2) > Param::GetFloat(Param::udcmin) ? STAT_NONE : STAT_UDCLOW;
     //stt |= Param::GetFloat(Param::BMS_IsoMeas) > Param::GetFloat(Param::BMS_IsoLimit) ? STAT_NONE : STAT_ISOFAULT;
     Param::SetInt(Param::status, stt);
 
     int safety_override = Param::GetInt(Param::SafetyOverride);
 
+    localContactors.SetTopology(IOMatrix::GetPin(IOMatrix::NEGCONTACTOR) == &DigIo::dummypin ?
+                                ContactorSeq::TOP_LOCAL_NONEG : ContactorSeq::TOP_LOCAL);
+    uint8_t contactorCond = ContactorConditions(t.idc);
+    uint8_t lastContactors = localContactors.GetOutputs();
+    uint8_t contactors = localContactors.Run(opmode, contactorCond);
+
+    if (contactors & ContactorSeq::CT_MAIN) DigIo::dcsw_out.Set(); else DigIo::dcsw_out.Clear();
+    if (contactors & ContactorSeq::CT_PRECHARGE) DigIo::prec_out.Set(); else DigIo::prec_out.Clear();
+    if (contactors & ContactorSeq::CT_NEGATIVE)
+        IOMatrix::GetPin(IOMatrix::NEGCONTACTOR)->Set();
+    else
+        IOMatrix::GetPin(IOMatrix::NEGCONTACTOR)->Clear();
+    if (contactors & ~lastContactors & ContactorSeq::CT_PRECHARGE) Precharge::Start(udc);
+    Param::SetInt(Param::CtrStep, localContactors.GetStep());
+
     switch (opmode)
     {
     case MOD_OFF:
         initbyStart=false;
         initbyCharge=false;
+        preHeater.SetInitByPreHeat(false);
         DigIo::inv_out.Clear();//inverter power off
         IOMatrix::GetPin(IOMatrix::COOLANTPUMP)->Clear();//Coolant pump off if used
         Param::SetInt(Param::dir, Park); // shift to park/neutral on shutdown regardless of shifter pos
         selectedVehicle->DashOff();
         StartSig=false;//reset for next time
 
-        if(rlyDly!=0) rlyDly--;//here we are going to pause to allow system shut down before opening HV contactors
-        if(rlyDly==0)
-        {
-            DigIo::dcsw_out.Clear();
-            IOMatrix::GetPin(IOMatrix::NEGCONTACTOR)->Clear();//Negative contactors off if used
-            DigIo::prec_out.Clear();
-        }
         //T15ON (powertrain aux power) is driven centrally after the switch, with an off-delay.
         if (((stt & (STAT_POTPRESSED | STAT_UDCLOW)) == STAT_NONE) || safety_override)
         {
@@ -683,7 +1009,6 @@ static void Ms10Task(void)
                 //proceed to precharge if 1)throttle not pressed , 2)ign on , 3)start signal rx
                 opmode = MOD_PRECHARGE;
                 initbyStart=true;
-                rlyDly=25;//Recharge sequence timer
                 vehicleStartTime = rtc_get_counter_val();
             }
         }
@@ -691,53 +1016,81 @@ static void Ms10Task(void)
         if(chargeMode && (stt & (STAT_POTPRESSED | STAT_UDCLIM)) == STAT_NONE)
         {
             opmode = MOD_PRECHARGE;//proceed to precharge if charge requested.
-            rlyDly=25;//Recharge sequence timer
             vehicleStartTime = rtc_get_counter_val();
             initbyCharge=true;
         }
+
+        if(opmode == MOD_OFF && preHeater.GetRunPreHeat() && (stt & (STAT_POTPRESSED | STAT_UDCLIM)) == STAT_NONE)
+        {
+            opmode = MOD_PRECHARGE;//HV for the heater only
+            vehicleStartTime = rtc_get_counter_val();
+            preHeater.SetInitByPreHeat(true);
+        }
         Param::SetInt(Param::opmode, opmode);
         break;                
 
     case MOD_PRECHARGE:
-        if (!chargeMode)
+        if (!chargeMode && !preHeater.GetInitByPreHeat())
         {
-            if(selectedInverter != &openInv)DigIo::inv_out.Set();//inverter power on but not if we are in charge mode and not if OI
+            if(!inverterSlot.Get<Can_OI>())DigIo::inv_out.Set();//inverter power on but not if we are in charge mode and not if OI
         }
-        else if((Param::GetInt(Param::ShuntType) == 0) && selectedInverter == &leafInv)//Shunt 0 + Leaf is precharge using leaf inverter voltage
+        else if((t.shuntType == 0) && inverterSlot.Get<LeafINV>())//Shunt 0 + Leaf is precharge using leaf inverter voltage
         {
             DigIo::inv_out.Set(); //inverter power on
         }
-        IOMatrix::GetPin(IOMatrix::NEGCONTACTOR)->Set();
         IOMatrix::GetPin(IOMatrix::COOLANTPUMP)->Set();
-        if(rlyDly!=0) rlyDly--;//here we are going to pause before energising precharge to prevent too many contactors pulling amps at the same time
-        if(rlyDly==0) DigIo::prec_out.Set();//commence precharge
+        if(localContactors.IsDone())//precharge relay is closed
+        {
+            float ubat = Param::GetFloat(Param::udc2) > Param::GetFloat(Param::udcmin) ? Param::GetFloat(Param::udc2) : 0;
+
+            Precharge::Run(udc, ubat, Param::GetFloat(Param::udcsw), Param::GetFloat(Param::PrechargeTol),
+                           Param::GetInt(Param::PrechargeTimeout) * 1000, Param::GetInt(Param::PchTauMin));
+            if (Precharge::HasEstimate())
+            {
+                Param::SetFloat(Param::PchTau, Precharge::GetTau());
+                Param::SetFloat(Param::PchUfinal, Precharge::GetFinal());
+            }
+            //Close enough to the battery voltage, no need to wait for udcsw. Without a valid
+            //battery voltage the engine only reports done once udcsw is reached.
+            if (Precharge::GetState() == Precharge::PCH_DONE)
+            {
+                stt &= ~STAT_UDCBELOWUDCSW;
+                Param::SetInt(Param::PchTime, Precharge::GetElapsed());
+            }
+        }
         if (StartSig && (stt & (STAT_POTPRESSED | STAT_UDCBELOWUDCSW | STAT_UDCLOW)) == STAT_NONE)
         {
             opmode = MOD_RUN;
             StartSig=false;//reset for next time
-            rlyDly=25;//Recharge sequence timer
             Param::SetInt(Param::TorqDerate,0);//clear torque derate reason
         }
-        if(chargeMode && (stt & (STAT_POTPRESSED | STAT_UDCBELOWUDCSW | STAT_UDCLIM)) == STAT_NONE)
+        if((chargeMode || preHeater.GetInitByPreHeat()) && (stt & (STAT_POTPRESSED | STAT_UDCBELOWUDCSW | STAT_UDCLIM)) == STAT_NONE)
         {
-            opmode = MOD_CHARGE;
-            rlyDly=500;//Recharge sequence timer  //10 seconds
+            opmode = MOD_CHARGE;//also used for preheating, HV without the inverter
             Param::SetInt(Param::TorqDerate,0);//clear torque derate reason
         }
-        if(initbyCharge && !chargeMode) opmode = MOD_OFF;// These two statements catch a precharge hang from either start mode or run mode.
+        if(initbyCharge && !chargeMode) opmode = MOD_OFF;// These statements catch a precharge hang from either start mode or run mode.
         if(initbyStart && !selectedVehicle->Ready()) opmode = MOD_OFF;
-        if (opmode == MOD_PRECHARGE && rtc_get_counter_val() > (vehicleStartTime + Param::GetInt(Param::PrechargeTimeout)))
+        if(preHeater.GetInitByPreHeat() && !preHeater.GetRunPreHeat() && !chargeMode) opmode = MOD_OFF;
+        if (opmode == MOD_PRECHARGE &&
+            (rtc_get_counter_val() > (vehicleStartTime + Param::GetInt(Param::PrechargeTimeout)) ||
+             (localContactors.IsDone() && Precharge::GetState() >= Precharge::PCH_FAILSLOW)))
         {
             if (safety_override && initbyStart)
             {
                 opmode = MOD_RUN;
                 StartSig=false;//reset for next time
-                rlyDly=25;//Recharge sequence timer
             }
             else
             {
                 DigIo::prec_out.Clear();
-                ErrorMessage::Post(ERR_PRECHARGE);
+                if (Precharge::GetState() == Precharge::PCH_FAILLOAD)
+                    FaultLog::Post(ERR_PRECHARGELOAD);
+                else if (Precharge::GetState() == Precharge::PCH_FAILFAST)
+                    FaultLog::Post(ERR_PRECHARGEFAST);
+                else
+                    FaultLog::Post(ERR_PRECHARGE);
+                BlackBox::Trigger(BlackBox::TRG_PRECHARGE);
                 opmode = MOD_PCHFAIL;
             }  
         }
@@ -746,24 +1099,29 @@ static void Ms10Task(void)
 
     case MOD_PCHFAIL:
         StartSig=false;
-        DigIo::prec_out.Clear();//explicitly turn off precharge relay in a fail condition
         if(initbyCharge && !chargeMode) opmode = MOD_OFF;//only go to off if the signal from charge or vehicle start is removed
         if(initbyStart && !selectedVehicle->Ready()) opmode = MOD_OFF;//this avoids oscillation in the event of a precharge system failure
+        if(preHeater.GetInitByPreHeat() && !preHeater.GetRunPreHeat()) opmode = MOD_OFF;
         Param::SetInt(Param::opmode, opmode);
         break;
  
     case MOD_CHARGE:
-        if(rlyDly!=0) rlyDly--;//here we are going to pause before energising precharge to prevent too many contactors pulling amps at the same time
-        if(rlyDly==0)
+        if(preHeater.GetInitByPreHeat() && !chargeMode && selectedVehicle->Start() && selectedVehicle->Ready() &&
+           (stt & (STAT_POTPRESSED | STAT_UDCBELOWUDCSW | STAT_UDCLOW)) == STAT_NONE)
         {
-            DigIo::dcsw_out.Set();
-            if(!chargeMode)
-            {
-                //Charger commanded 0W (ChRun=false). Hand off to the shared shutdown-request
-                //state so the PCS and other HV devices wind down before the contactors open.
-                opmode = MOD_SHUTDOWN_REQUEST;
-                shutdownReq=150; //(150 x 10ms = 1.5s)
-            }
+            //Car started while preheating. HV is already up, so go straight to run
+            //rather than keeping the driver waiting for the preheat to time out.
+            preHeater.Stop();
+            preHeater.SetInitByPreHeat(false);
+            initbyStart=true;
+            opmode = MOD_RUN;
+            Param::SetInt(Param::TorqDerate,0);//clear torque derate reason
+        }
+        else if(localContactors.IsDone() && !chargeMode && !preHeater.GetRunPreHeat())
+        {
+            //Charger commanded 0W (ChRun=false) and no preheat running. Hand off to the shared shutdown-request
+            //state so the PCS and other HV devices wind down before the contactors open.
+            opmode = MOD_SHUTDOWN_REQUEST;
         }
         ErrorMessage::UnpostAll();
         
@@ -771,12 +1129,7 @@ static void Ms10Task(void)
         break;
 
     case MOD_RUN:
-        if(rlyDly!=0) rlyDly--;//here we are going to pause before energising precharge to prevent too many contactors pulling amps at the same time
-        if(rlyDly==0)
-        {
-            DigIo::dcsw_out.Set();
-            DigIo::inv_out.Set();//inverter power on
-        }
+        if(localContactors.IsDone()) DigIo::inv_out.Set();//inverter power on
         Param::SetInt(Param::opmode, MOD_RUN);
         ErrorMessage::UnpostAll();
         // Only leave RUN once it is physically safe to open the contactors:
@@ -784,11 +1137,10 @@ static void Ms10Task(void)
         
         //  dir 0/2   : selector in Neutral or Park - driver intent, and redundancy if the speed signal drops out
         if(!selectedVehicle->Ready() &&
-           ABS(Param::GetInt(Param::speed)) < 50 &&
-           (Param::GetInt(Param::dir) == Neutral || Param::GetInt(Param::dir) == Park))
+           ABS(t.speed) < 50 &&
+           (t.dir == Neutral || t.dir == Park))
         {
             opmode = MOD_SHUTDOWN_REQUEST;
-            shutdownReq=150; //(150 x 10ms = 1.5s) let HV devices wind down before contactors open
         }
         Param::SetInt(Param::opmode, opmode);
         break;
@@ -797,15 +1149,9 @@ static void Ms10Task(void)
         //HV stays live and opmode 5 is broadcast on CAN so downstream HV devices
         //(Tesla PCS charger + DC-DC, A/C compressor) can wind down gracefully before
         //the contactors open. Hold here for the wind-down window, then drop to MOD_OFF.
-        DigIo::dcsw_out.Set();
         DigIo::inv_out.Clear();//inverter no longer needed
         Param::SetInt(Param::dir, Park); // shift to park/neutral on shutdown regardless of shifter pos
-        if(shutdownReq!=0) shutdownReq--;
-        if(shutdownReq==0 && ABS(Param::GetInt(Param::idc)) < 5) //  idc<5 = near-zero DC current, no arc on opening
-        {
-            opmode = MOD_OFF; // HVCU box opens contactors on opmode 0)
-            rlyDly=250;//settle delay for local HV outputs 
-        }
+        if(localContactors.IsDone()) opmode = MOD_OFF; //wind-down window over and no current flowing
         Param::SetInt(Param::opmode, opmode);
         break;
     }
@@ -813,8 +1159,8 @@ static void Ms10Task(void)
     //Powertrain aux power (T15ON) feeds the separate, BMW-isolated powertrain supply.
     //Keep it on while ignition/charge is active or HV is live, then hold it a few seconds
     //after MOD_OFF so the inverter and PCS controller power down on their own terms instead
-    //of browning out as the contactors open.
-    static uint16_t t15Hold = 0;
+    //of browning out as the contactors open. The hold always runs out: no inverter driver
+    //can tell when it has powered down and the other devices only report HV draw.
     if (Param::GetInt(Param::T15Stat) || chargeMode || opmode != MOD_OFF)
         t15Hold = 300;//3s (300 x 10ms), refreshed while active
     else if (t15Hold != 0)
@@ -824,279 +1170,504 @@ static void Ms10Task(void)
     else
         IOMatrix::GetPin(IOMatrix::T15ON)->Clear();
 
+    preHeater.Ms10Task();
     ControlCabHeater(opmode);
-    if (Param::GetInt(Param::ShuntType) == 2)  SBOX::ControlContactors(opmode,canInterface[Param::GetInt(Param::ShuntCan)]);//BMW contactor box
-    if (Param::GetInt(Param::ShuntType) == 3)  VWBOX::ControlContactors(opmode,canInterface[Param::GetInt(Param::ShuntCan)]);//VW contactor box
-    if (Param::GetInt(Param::ShuntType) == 4)  HVCU::ControlContactors(opmode,canInterface[Param::GetInt(Param::ShuntCan)]);//Custom contactor box in E90
+    if (t.shuntType == 2)  boxContactors.SetTopology(ContactorSeq::TOP_SBOX);
+    if (t.shuntType == 3)  boxContactors.SetTopology(ContactorSeq::TOP_VWBOX);
+    if (t.shuntType == 4)  boxContactors.SetTopology(ContactorSeq::TOP_HVCU);
+    uint8_t boxOutputs = boxContactors.Run(opmode, contactorCond);
+    if (t.shuntType == 2)  SBOX::ControlContactors(boxOutputs,canInterface[Param::GetInt(Param::ShuntCan)]);//BMW contactor box
+    if (t.shuntType == 3)  VWBOX::ControlContactors(boxOutputs,canInterface[Param::GetInt(Param::ShuntCan)]);//VW contactor box
+    if (t.shuntType == 4)  HVCU::ControlContactors(boxOutputs,canInterface[Param::GetInt(Param::ShuntCan)]);//Custom contactor box in E90
+
+    canMapScheduler->Run(canMap);
+    BlackBox::Sample();
+    TaskWatchdog::Leave();
 }
 
 static void Ms1Task(void)
 {
-    selectedInverter->Task1Ms();
-    selectedVehicle->Task1Ms();
-    selectedCharger->Task1Ms();
-    selectedChargeInt->Task1Ms();
-    selectedShifter->Task1Ms();
-    selectedDCDC->Task1Ms();
+    TaskWatchdog::Enter(TaskWatchdog::TASK_1MS);
+    if (inverterSlot.Has(DEVTASK_1MS)) selectedInverter->Task1Ms();
+    if (vehicleSlot.Has(DEVTASK_1MS)) selectedVehicle->Task1Ms();
+    if (chargerSlot.Has(DEVTASK_1MS)) selectedCharger->Task1Ms();
+    if (chargeIntSlot.Has(DEVTASK_1MS)) selectedChargeInt->Task1Ms();
+    if (shifterSlot.Has(DEVTASK_1MS)) selectedShifter->Task1Ms();
+    if (dcdcSlot.Has(DEVTASK_1MS)) selectedDCDC->Task1Ms();
+    BulkSdo::Task1Ms();
+    Sequence::RunAll();
+    AnaFilter::Run();
+    canOBD2.Task1Ms();
+    TaskWatchdog::Leave();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//CAN3 is only used by a few devices, it is brought up when the first of them is selected
+#if defined(DRV_CHADEMO) || defined(DRV_AMPERAHEATER)
+static void EnableCan3()
+{
+    if (can3Enabled) return;
+
+    BootProfile::Mark(BOOT_DEVICES);
+    spi2_setup();
+    DigIo::mcp_sby.Clear();//enable can3
+    CANSPI_Initialize();// init the MCP25625 on CAN3
+    CANSPI_ENRx_IRQ();  //init CAN3 Rx IRQ
+    can3Enabled = true;
+    BootProfile::Mark(BOOT_CAN3);
+}
+#endif
+
+//Same for LIN which only the VW heater uses, USART1 is set up when it starts its schedule
+#ifdef DRV_VWHEATER
+static void StartLin(vwHeater* heater)
+{
+    BootProfile::Mark(BOOT_DEVICES);
+    heater->SetLinInterface();
+    BootProfile::Mark(BOOT_LIN);
+}
+#endif
+
+static bool reconfiguring = false;
+static bool canRebuildPending = false;
+
+//Drops all user CAN messages and lets the devices register theirs again.
+//While devices are reconfigured as a batch this only happens once at the end
+static void RebuildCanMessages()
+{
+    if (reconfiguring)
+    {
+        canRebuildPending = true;
+        return;
+    }
+    BootProfile::Mark(BOOT_DEVICES);
+    //This will call SetCanFilters() via the Clear Callback
+    canInterface[0]->ClearUserMessages();
+    canInterface[1]->ClearUserMessages();
+    BootProfile::Mark(BOOT_CANFILT);
+}
+
+static void BeginReconfigure()
+{
+    reconfiguring = true;
+}
+
+static void EndReconfigure()
+{
+    reconfiguring = false;
+
+    if (canRebuildPending)
+    {
+        canRebuildPending = false;
+        RebuildCanMessages();
+    }
+}
+
 static void UpdateInv()
 {
     selectedInverter->DeInit();
+    selectedInverter = &NoInverter; //Tasks keep running while the slot is rebuilt
+    inverterSlot.Clear();
     switch (Param::GetInt(Param::Inverter))
     {
     case InvModes::NoInv:
-        selectedInverter = &NoInverter;
+    case InvModes::UserCAN: //Mapped via CAN map, no driver
         break;
+#ifdef DRV_LEAFINV
     case InvModes::Leaf_Gen1:
-        selectedInverter = &leafInv;
+        selectedInverter = inverterSlot.Create<LeafINV>();
         break;
+#endif
+#ifdef DRV_GS450H
     case InvModes::GS450H:
-        selectedInverter = &gs450Inverter;
-        gs450Inverter.SetGS450H();
+        selectedInverter = inverterSlot.Create<GS450HClass>();
+        inverterSlot.Get<GS450HClass>()->SetGS450H();
         break;
     case InvModes::GS300H:
-        selectedInverter = &gs450Inverter;
-        gs450Inverter.SetGS300H();
+        selectedInverter = inverterSlot.Create<GS450HClass>();
+        inverterSlot.Get<GS450HClass>()->SetGS300H();
         break;
     case InvModes::Prius_Gen3:
-        selectedInverter = &gs450Inverter;
-        gs450Inverter.SetPrius();
+        selectedInverter = inverterSlot.Create<GS450HClass>();
+        inverterSlot.Get<GS450HClass>()->SetPrius();
         break;
+#endif
+#ifdef DRV_OUTLANDERINV
     case InvModes::Outlander:
-        selectedInverter = &outlanderInv;
+        selectedInverter = inverterSlot.Create<OutlanderInverter>();
         OutlanderCAN = true;
         break;
+#endif
+#ifdef DRV_OPENINV
     case InvModes::OpenI:
-        selectedInverter = &openInv;
+        selectedInverter = inverterSlot.Create<Can_OI>();
         break;
+#endif
+#ifdef DRV_REAROUTLANDERINV
     case InvModes::RearOutlander:
-        selectedInverter = &rearoutlanderInv;
+        selectedInverter = inverterSlot.Create<RearOutlanderInverter>();
         OutlanderCAN = true;
         break;
+#endif
+#ifdef DRV_T2C
     case InvModes::T2C:
-        selectedInverter = &evControlsT2C;
+        selectedInverter = inverterSlot.Create<EvControlsT2C>();
+        break;
+#endif
+    default:
+        //Not part of this build profile
+        FaultLog::Post(ERR_NODRIVER);
         break;
     }
-    //This will call SetCanFilters() via the Clear Callback
-    canInterface[0]->ClearUserMessages();
-    canInterface[1]->ClearUserMessages();
+    RebuildCanMessages();
 }
 
 static void UpdateVehicle()
 {
+    selectedVehicle = &VehicleNone; //Tasks keep running while the slot is rebuilt
+    vehicleSlot.Clear();
     switch (Param::GetInt(Param::Vehicle))
     {
     case vehicles::None:
-        selectedVehicle = &VehicleNone;
         break;
+#ifdef DRV_E39
     case vehicles::vBMW_E39:
-        selectedVehicle = &e39Vehicle;
-        e39Vehicle.SetE46(false);
+        selectedVehicle = vehicleSlot.Create<BMW_E39>();
+        vehicleSlot.Get<BMW_E39>()->SetE46(false);
         break;
     case vehicles::vBMW_E46:
-        selectedVehicle = &e39Vehicle;
-        e39Vehicle.SetE46(true);
+        selectedVehicle = vehicleSlot.Create<BMW_E39>();
+        vehicleSlot.Get<BMW_E39>()->SetE46(true);
         break;
+#endif
+#ifdef DRV_E65
     case vehicles::vBMW_E65:
-        selectedVehicle = &e65Vehicle;
+        selectedVehicle = vehicleSlot.Create<BMW_E65>();
         break;
+#endif
+#ifdef DRV_VAG
     case vehicles::vVAG:
-        selectedVehicle = &vagVehicle;
+        selectedVehicle = vehicleSlot.Create<Can_VAG>();
         break;
+#endif
+#ifdef DRV_SUBARU
     case vehicles::vSUBARU:
-        selectedVehicle = &subaruVehicle;
+        selectedVehicle = vehicleSlot.Create<SubaruVehicle>();
         break;
+#endif
+#ifdef DRV_E31
     case vehicles::vBMW_E31:
-        selectedVehicle = &e31Vehicle;
+        selectedVehicle = vehicleSlot.Create<BMW_E31>();
         break;
+#endif
+#ifdef DRV_E90
     case vehicles::vBMW_E90:
-        selectedVehicle = &e90Vehicle;
+        selectedVehicle = vehicleSlot.Create<BMW_E90>();
         break;
+#endif
+#ifdef DRV_CLASSIC
     case vehicles::Classic:
-        selectedVehicle = &classVehicle;
+        selectedVehicle = vehicleSlot.Create<V_Classic>();
+        break;
+#endif
+    default:
+        //Not part of this build profile
+        FaultLog::Post(ERR_NODRIVER);
         break;
     }
-    //This will call SetCanFilters() via the Clear Callback
-    canInterface[0]->ClearUserMessages();
-    canInterface[1]->ClearUserMessages();
+    RebuildCanMessages();
 }
 
 static void UpdateCharger()
 {
     selectedCharger->DeInit();
+    selectedCharger = &nochg; //Tasks keep running while the slot is rebuilt
+    chargerSlot.Clear();
     switch (Param::GetInt(Param::chargemodes))
     {
     case ChargeModes::Off:
         chargeMode = false;
-        selectedCharger = &nochg;
         break;
+#ifdef DRV_EXTCHARGER
     case ChargeModes::EXT_DIGI:
-        selectedCharger = &chgdigi;
+        selectedCharger = chargerSlot.Create<extCharger>();
         break;
+#endif
+#ifdef DRV_AMPERACHARGER
     case ChargeModes::Volt_Ampera:
-        selectedCharger = &ampChg;
+        selectedCharger = chargerSlot.Create<amperaCharger>();
         break;
+#endif
+#ifdef DRV_NISSANPDM
     case ChargeModes::Leaf_PDM:
-        selectedCharger = &chargerPDM;
+        selectedCharger = chargerSlot.Create<NissanPDM>();
         break;
+#endif
+#ifdef DRV_TESLACHARGER
     case ChargeModes::TeslaOI:
-        selectedCharger = &ChargerTesla;
+        selectedCharger = chargerSlot.Create<teslaCharger>();
         break;
+#endif
+#ifdef DRV_OUTLANDERCHARGER
     case ChargeModes::Out_lander:
-        selectedCharger = &outChg;
+        selectedCharger = chargerSlot.Create<outlanderCharger>();
         OutlanderCAN = true;
         break;
+#endif
+#ifdef DRV_ELCON
     case ChargeModes::Elcon:
-        selectedCharger = &ChargerElcon;
+        selectedCharger = chargerSlot.Create<ElconCharger>();
+        break;
+#endif
+    default:
+        //Not part of this build profile
+        FaultLog::Post(ERR_NODRIVER);
         break;
-
     }
-    //This will call SetCanFilters() via the Clear Callback
-    canInterface[0]->ClearUserMessages();
-    canInterface[1]->ClearUserMessages();
+    RebuildCanMessages();
 }
 
 static void UpdateChargeInt()
 {
     selectedChargeInt->DeInit();
+    selectedChargeInt = &UnUsed; //Tasks keep running while the slot is rebuilt
+    chargeIntSlot.Clear();
     switch (Param::GetInt(Param::interface))
     {
     case ChargeInterfaces::Unused:
-        selectedChargeInt = &UnUsed;
         break;
+#ifdef DRV_CHADEMO
     case ChargeInterfaces::Chademo:
-        selectedChargeInt = &chademoFC;
+        selectedChargeInt = chargeIntSlot.Create<FCChademo>();
+        EnableCan3();
         break;
+#endif
+#ifdef DRV_I3LIM
     case ChargeInterfaces::i3LIM:
-        selectedChargeInt = &LIMFC;
+        selectedChargeInt = chargeIntSlot.Create<i3LIMClass>();
         break;
+#endif
+#ifdef DRV_CPC
     case ChargeInterfaces::CPC:
-        selectedChargeInt = &CPCcan;
+        selectedChargeInt = chargeIntSlot.Create<CPCClass>();
         break;
+#endif
+#ifdef DRV_FOCCCI
     case ChargeInterfaces::Foccci:
-        selectedChargeInt = &Focccican;
+        selectedChargeInt = chargeIntSlot.Create<FoccciClass>();
+        break;
+#endif
+    default:
+        //Not part of this build profile
+        FaultLog::Post(ERR_NODRIVER);
         break;
     }
-    //This will call SetCanFilters() via the Clear Callback
-    canInterface[0]->ClearUserMessages();
-    canInterface[1]->ClearUserMessages();
+    RebuildCanMessages();
 }
 
 static void UpdateHeater()
 {
     selectedHeater->DeInit();
+    selectedHeater = &Heaternone; //Tasks keep running while the slot is rebuilt
+    heaterSlot.Clear();
     switch (Param::GetInt(Param::Heater))
     {
     case HeatType::Noheater:
-        selectedHeater = &Heaternone;
         break;
+#ifdef DRV_AMPERAHEATER
     case HeatType::AmpHeater:
-        selectedHeater = &amperaHeater;
+        selectedHeater = heaterSlot.Create<AmperaHeater>();
+        EnableCan3();
         break;
+#endif
+#ifdef DRV_VWHEATER
     case HeatType::VW:
-        selectedHeater = &heaterVW;
-        heaterVW.SetLinInterface(lin);
+        selectedHeater = heaterSlot.Create<vwHeater>();
+        StartLin(heaterSlot.Get<vwHeater>());
         break;
+#endif
+#ifdef DRV_OUTLANDERHEATER
     case HeatType::OutlanderHeater:
-        selectedHeater = &outlanderCanHeater;
+        selectedHeater = heaterSlot.Create<OutlanderCanHeater>();
         OutlanderCAN = true;
         break;
+#endif
+    default:
+        //Not part of this build profile
+        FaultLog::Post(ERR_NODRIVER);
+        break;
     }
-    //This will call SetCanFilters() via the Clear Callback
-    canInterface[0]->ClearUserMessages();
-    canInterface[1]->ClearUserMessages();
+    RebuildCanMessages();
 }
 
 static void UpdateBMS()
 {
     selectedBMS->DeInit();
+    selectedBMS = &BMSnone; //Tasks keep running while the slot is rebuilt
+    bmsSlot.Clear();
     switch (Param::GetInt(Param::BMS_Mode))
     {
+    case BMSModes::BMSModeNoBMS:
+        break;
+#ifdef DRV_SIMPBMS
     case BMSModes::BMSModeSimpBMS:
-        selectedBMS = &BMSsimp;
+        selectedBMS = bmsSlot.Create<SimpBMS>();
         break;
+#endif
+#ifdef DRV_LEAFBMS
     case BMSModes::BMSModeLeafBMS:
-        selectedBMS = &BMSleaf;
+        selectedBMS = bmsSlot.Create<LeafBMS>();
         break;
+#endif
+#ifdef DRV_DAISYCHAIN
     case BMSModes::BMSModeDaisychainSingleBMS:
     case BMSModes::BMSModeDaisychainDualBMS:
-        selectedBMS = &BMSdaisychain;
+        selectedBMS = bmsSlot.Create<DaisychainBMS>();
         break;
+#endif
+#ifdef DRV_KANGOOBMS
     case BMSModes::BMSRenaultKangoo33BMS:
-        selectedBMS = &BMSRenaultKangoo33;
+        selectedBMS = bmsSlot.Create<KangooBMS>();
         break;
+#endif
+#ifdef DRV_DILITHIUM
     case BMSModes::BMSDilithiumMCU:
-        selectedBMS = &BMSDilithium;
+        selectedBMS = bmsSlot.Create<DilithiumMCU>();
         break;
+#endif
     default:
-        // Default to no BMS
-        selectedBMS = &BMSnone;
+        //Not part of this build profile
+        FaultLog::Post(ERR_NODRIVER);
         break;
     }
-    //This will call SetCanFilters() via the Clear Callback
-    canInterface[0]->ClearUserMessages();
-    canInterface[1]->ClearUserMessages();
+    RebuildCanMessages();
 }
 
 static void UpdateDCDC()
 {
     selectedDCDC->DeInit();
+    selectedDCDC = &DCDCnone; //Tasks keep running while the slot is rebuilt
+    dcdcSlot.Clear();
     switch (Param::GetInt(Param::DCdc_Type))
     {
     case DCDCModes::NoDCDC:
-        selectedDCDC = &DCDCnone;
         break;
 
+#ifdef DRV_TESLADCDC
     case DCDCModes::TeslaG2:
-        selectedDCDC = &DCDCTesla;
+        selectedDCDC = dcdcSlot.Create<TeslaDCDC>();
         break;
+#endif
 
     default:
-        // Default to no DCDC
-        selectedDCDC = &DCDCnone;
+        //Not part of this build profile
+        FaultLog::Post(ERR_NODRIVER);
         break;
     }
-    //This will call SetCanFilters() via the Clear Callback
-    canInterface[0]->ClearUserMessages();
-    canInterface[1]->ClearUserMessages();
+    RebuildCanMessages();
 }
 
 
 static void UpdateShifter()
 {
-
+    selectedShifter = &NoGearLever; //Tasks keep running while the slot is rebuilt
+    shifterSlot.Clear();
     switch (Param::GetInt(Param::GearLvr))
     {
     case ShifterModes::NoShifter:
-        selectedShifter = &shifterNone;
         break;
 
+#ifdef DRV_F30LEVER
     case ShifterModes::BMWF30:
-        selectedShifter = &F30GearLever;
+        selectedShifter = shifterSlot.Create<F30_Lever>();
         break;
+#endif
 
+#ifdef DRV_JLRG1
     case ShifterModes::JLRG1:
-        selectedShifter = &JLRG1shift;
+        selectedShifter = shifterSlot.Create<JLR_G1>();
         break;
+#endif
 
+#ifdef DRV_JLRG2
     case ShifterModes::JLRG2:
-        selectedShifter = &JLRG2shift;
+        selectedShifter = shifterSlot.Create<JLR_G2>();
         break;
+#endif
 
+#ifdef DRV_E65LEVER
     case ShifterModes::BMWE65:
-        selectedShifter = &E65GearLever;
+        selectedShifter = shifterSlot.Create<E65_Lever>();
         break;
+#endif
 
     default:
-        // Default to no shifter
-        selectedShifter = &shifterNone;
+        //Not part of this build profile
+        FaultLog::Post(ERR_NODRIVER);
         break;
     }
-    //This will call SetCanFilters() via the Clear Callback
-    canInterface[0]->ClearUserMessages();
-    canInterface[1]->ClearUserMessages();
+    RebuildCanMessages();
+}
+
+//Device categories and the selection each slot was last built for
+struct DeviceSelection
+{
+    Param::PARAM_NUM param;
+    void (*update)();
+    bool fixed; //hardwired by the build profile, only set up once at boot
+    int applied; //fixed devices start out with the selection of the build profile
+};
+
+#define DEVICE_SELECTION(param, update, slot) \
+    { param, update, decltype(slot)::IsFixed, decltype(slot)::Selection }
+
+static DeviceSelection deviceSelections[] =
+{
+    DEVICE_SELECTION(Param::Inverter, UpdateInv, inverterSlot),
+    DEVICE_SELECTION(Param::Vehicle, UpdateVehicle, vehicleSlot),
+    DEVICE_SELECTION(Param::chargemodes, UpdateCharger, chargerSlot),
+    DEVICE_SELECTION(Param::interface, UpdateChargeInt, chargeIntSlot),
+    DEVICE_SELECTION(Param::BMS_Mode, UpdateBMS, bmsSlot),
+    DEVICE_SELECTION(Param::Heater, UpdateHeater, heaterSlot),
+    DEVICE_SELECTION(Param::DCdc_Type, UpdateDCDC, dcdcSlot),
+    DEVICE_SELECTION(Param::GearLvr, UpdateShifter, shifterSlot)
+};
+
+//Selects all devices from their parameters and registers their CAN messages once
+static void ReconfigureDevices()
+{
+    BeginReconfigure();
+    for (DeviceSelection& sel : deviceSelections)
+    {
+        //A hardwired device ignores what is stored, the parameter shows what runs.
+        //Its case in the Update function still does the per device setup, e.g. CAN3.
+        if (sel.fixed)
+            Param::SetInt(sel.param, sel.applied);
+        else
+            sel.applied = Param::GetInt(sel.param);
+        sel.update();
+    }
+    EndReconfigure();
+}
+
+//Rebuilds a slot only if its selection really changed. Saving the same value again,
+//e.g. from the web interface or a parameter restore, must not reset a running driver.
+static void ChangeDevice(Param::PARAM_NUM paramNum)
+{
+    for (DeviceSelection& sel : deviceSelections)
+    {
+        if (sel.param != paramNum || Param::GetInt(paramNum) == sel.applied) continue;
+
+        if (sel.fixed)
+        {
+            //The fixed device can't be torn down or replaced, keep the selection it runs with
+            Param::SetInt(paramNum, sel.applied);
+            continue;
+        }
+
+        sel.applied = Param::GetInt(paramNum);
+        sel.update();
+    }
 }
 
 
@@ -1131,67 +1702,12 @@ static void SetCanFilters()
 
     canInterface[1]->RegisterUserMessage(0x601); //CanSDO
     canInterface[0]->RegisterUserMessage(0x601); //CanSDO
+    BulkSdo::RegisterCanMessages(canInterface[0]); //Bulk SDO on CAN1
 
 }
 
-void Param::Change(Param::PARAM_NUM paramNum)
+static void CheckReverseMotor()
 {
-    // This function is called when the user changes a parameter
-    switch (paramNum)
-    {
-    case Param::Inverter:
-        UpdateInv();
-        break;
-    case Param::Vehicle:
-        UpdateVehicle();
-        break;
-    case Param::chargemodes:
-        UpdateCharger();
-        break;
-    case Param::interface:
-        UpdateChargeInt();
-        break;
-    case Param::Heater:
-        UpdateHeater();
-        break;
-    case Param::BMS_Mode:
-        UpdateBMS();
-        break;
-    case Param::DCdc_Type:
-        UpdateDCDC();
-        break;
-    case Param::GearLvr:
-        UpdateShifter();
-        break;
-    case Param::InverterCan:
-    case Param::VehicleCan:
-    case Param::ShuntCan:
-    case Param::LimCan:
-    case Param::ChargerCan:
-        canInterface[0]->ClearUserMessages();
-        canInterface[1]->ClearUserMessages();
-        break;
-    case Param::CAN3Speed:
-        CANSPI_Initialize();// init the MCP25625 on CAN3
-        CANSPI_ENRx_IRQ();  //init CAN3 Rx IRQ
-        break;
-    case Param::Tim3_Presc:
-    case Param::Tim3_Period:
-    case Param::Tim3_1_OC:
-    case Param::Tim3_2_OC:
-    case Param::Tim3_3_OC:
-    case Param::PWM1Func:
-    case Param::PWM2Func:
-    case Param::PWM3Func:
-        tim3_setup();
-        break;
-    case Param::CP_PWM:
-        //timer_set_oc_value(TIM3, TIM_OC3, (Param::GetInt(Param::CP_PWM)*66)-16);//No duty set here
-        break;
-    default:
-        break;
-    }
-
     if(Param::GetInt(Param::reversemotor) != 0)
     {
         if(Param::GetInt(Param::Inverter) == InvModes::RearOutlander)
@@ -1203,7 +1719,10 @@ void Param::Change(Param::PARAM_NUM paramNum)
             Param::SetInt(Param::reversemotor,0);
         }
     }
+}
 
+static void ApplyThrottleParams()
+{
     Throttle::potmin[0] = Param::GetInt(Param::potmin);
     Throttle::potmax[0] = Param::GetInt(Param::potmax);
     Throttle::potmin[1] = Param::GetInt(Param::pot2min);
@@ -1229,42 +1748,174 @@ void Param::Change(Param::PARAM_NUM paramNum)
     Throttle::speedLimit = Param::GetInt(Param::revlim);
     Throttle::regenRamp = Param::GetFloat(Param::regenramp);
     Throttle::throttleRamp = Param::GetFloat(Param::throtramp);
-    Throttle::throtmaxRev = Param::GetFloat(throtmaxRev);
+    Throttle::throtmaxRev = Param::GetFloat(Param::throtmaxRev);
     Throttle::regenBrake = Param::GetFloat(Param::regenBrake);
+}
 
+static void ApplyChargeTargets()
+{
     targetCharger=static_cast<ChargeModes>(Param::GetInt(Param::chargemodes));//get charger setting from menu
     targetChgint=static_cast<ChargeInterfaces>(Param::GetInt(Param::interface));//get interface setting from menu
+}
+
+static void ApplyChargeTimer()
+{
     if(ChgSet==1)
     {
         seconds=Param::GetInt(Param::Set_Sec);//only update these params if charge command is set to disable
         minutes=Param::GetInt(Param::Set_Min);
         hours=Param::GetInt(Param::Set_Hour);
         days=Param::GetInt(Param::Set_Day);
-        ChgHrs_tmp=GetInt(Param::Chg_Hrs);
-        ChgMins_tmp=GetInt(Param::Chg_Min);
-        ChgDur_tmp=GetInt(Param::Chg_Dur);
+        ChgHrs_tmp=Param::GetInt(Param::Chg_Hrs);
+        ChgMins_tmp=Param::GetInt(Param::Chg_Min);
+        ChgDur_tmp=Param::GetInt(Param::Chg_Dur);
     }
     ChgSet = Param::GetInt(Param::Chgctrl);//0=enable,1=disable,2=timer.
-    ChgTicks = (GetInt(Param::Chg_Dur)*300);//number of 200ms ticks that equates to charge timer in minutes
-    IOMatrix::AssignFromParams();
-    IOMatrix::AssignFromParamsAnalogue();
+    ChgTicks = (Param::GetInt(Param::Chg_Dur)*300);//number of 200ms ticks that equates to charge timer in minutes
+}
+
+static void ApplyPreheatTimer()
+{
+    preHeater.ParamsChange();
+}
+
+static void ApplyHeaterControl()
+{
+    HeatCtrl::SetParams(Param::GetInt(Param::HeatKp), Param::GetInt(Param::HeatKi), Param::GetInt(Param::HeatRamp));
+}
+
+//State derived from parameters and the parameters it is derived from. Param::Change()
+//only recomputes what depends on the changed parameter, Param::PARAM_LAST recomputes everything.
+static const Param::PARAM_NUM reverseMotorDeps[] = { Param::reversemotor, Param::Inverter };
+static const Param::PARAM_NUM throttleDeps[] =
+{
+    Param::potmin, Param::potmax, Param::pot2min, Param::pot2max, Param::regenrpm, Param::regenendrpm,
+    Param::throtrpmfilt, Param::regenmax, Param::throtmax, Param::throtmin, Param::throtdead, Param::revlim,
+    Param::regenramp, Param::throtramp, Param::throtmaxRev, Param::regenBrake
+};
+static const Param::PARAM_NUM chargeTargetDeps[] = { Param::chargemodes, Param::interface };
+static const Param::PARAM_NUM chargeTimerDeps[] =
+{
+    Param::Chgctrl, Param::Set_Sec, Param::Set_Min, Param::Set_Hour, Param::Set_Day,
+    Param::Chg_Hrs, Param::Chg_Min, Param::Chg_Dur
+};
+static const Param::PARAM_NUM preheatTimerDeps[] = { Param::Control, Param::Pre_Hrs, Param::Pre_Min, Param::Pre_Dur };
+static const Param::PARAM_NUM heaterControlDeps[] = { Param::HeatKp, Param::HeatKi, Param::HeatRamp };
+static const Param::PARAM_NUM ioDeps[] =
+{
+    Param::Out1Func, Param::Out2Func, Param::Out3Func, Param::SL1Func, Param::SL2Func, Param::SPOFunc,
+    Param::PWM1Func, Param::PWM2Func, Param::PWM3Func, Param::GP12VInFunc,
+    Param::HVReqFunc, Param::PB1InFunc, Param::PB2InFunc, Param::PB3InFunc
+};
+static const Param::PARAM_NUM analogueIoDeps[] = { Param::GPA1Func, Param::GPA2Func };
+
+struct ParamSubscriber
+{
+    void (*apply)();
+    const Param::PARAM_NUM* deps;
+    int numDeps;
+};
+
+#define PARAM_SUBSCRIBER(fn, deps) { fn, deps, sizeof(deps) / sizeof(deps[0]) }
+
+static const ParamSubscriber paramSubscribers[] =
+{
+    PARAM_SUBSCRIBER(CheckReverseMotor, reverseMotorDeps),
+    PARAM_SUBSCRIBER(ApplyThrottleParams, throttleDeps),
+    PARAM_SUBSCRIBER(ApplyChargeTargets, chargeTargetDeps),
+    PARAM_SUBSCRIBER(ApplyChargeTimer, chargeTimerDeps),
+    PARAM_SUBSCRIBER(ApplyPreheatTimer, preheatTimerDeps),
+    PARAM_SUBSCRIBER(ApplyHeaterControl, heaterControlDeps),
+    PARAM_SUBSCRIBER(IOMatrix::AssignFromParams, ioDeps),
+    PARAM_SUBSCRIBER(IOMatrix::AssignFromParamsAnalogue, analogueIoDeps)
+};
+
+static void NotifyParamSubscribers(Param::PARAM_NUM paramNum)
+{
+    for (const ParamSubscriber& sub : paramSubscribers)
+    {
+        bool affected = paramNum == Param::PARAM_LAST;
+
+        for (int i = 0; i < sub.numDeps && !affected; i++)
+            affected = sub.deps[i] == paramNum;
+
+        if (affected) sub.apply();
+    }
+}
+
+void Param::Change(Param::PARAM_NUM paramNum)
+{
+    // This function is called when the user changes a parameter
+    switch (paramNum)
+    {
+    case Param::Inverter:
+    case Param::Vehicle:
+    case Param::chargemodes:
+    case Param::interface:
+    case Param::Heater:
+    case Param::BMS_Mode:
+    case Param::DCdc_Type:
+    case Param::GearLvr:
+        ChangeDevice(paramNum);
+        break;
+    case Param::InverterCan:
+    case Param::VehicleCan:
+    case Param::ShuntCan:
+    case Param::LimCan:
+    case Param::ChargerCan:
+        RebuildCanMessages();
+        break;
+    case Param::CAN3Speed:
+        if (can3Enabled)
+        {
+            CANSPI_Initialize();// init the MCP25625 on CAN3
+            CANSPI_ENRx_IRQ();  //init CAN3 Rx IRQ
+        }
+        break;
+    case Param::Tim3_Presc:
+    case Param::Tim3_Period:
+    case Param::Tim3_1_OC:
+    case Param::Tim3_2_OC:
+    case Param::Tim3_3_OC:
+    case Param::PWM1Func:
+    case Param::PWM2Func:
+    case Param::PWM3Func:
+        tim3_setup();
+        break;
+    case Param::CP_PWM:
+        //timer_set_oc_value(TIM3, TIM_OC3, (Param::GetInt(Param::CP_PWM)*66)-16);//No duty set here
+        break;
+    default:
+        break;
+    }
+
+    NotifyParamSubscribers(paramNum);
 }
 
 
 static bool CanCallback(uint32_t id, uint32_t data[2], uint8_t dlc) //This is where we go when a defined CAN message is received.
 {
     dlc = dlc;
+    BootProfile::FirstCan();
     switch (id)
     {
     case 0x7DF:
+    case 0x7E0:
         canOBD2.DecodeCAN(id,data);
         break;
 
+    case BULKSDO_REQ_ID:
+        BulkSdo::DecodeCAN(id, data);
+        break;
+
     default:
-        if (Param::GetInt(Param::ShuntType) == 1)  ISA::DecodeCAN(id, data);
-        if (Param::GetInt(Param::ShuntType) == 2)  SBOX::DecodeCAN(id, data);
-        if (Param::GetInt(Param::ShuntType) == 3)  VWBOX::DecodeCAN(id, data);
-        if (Param::GetInt(Param::ShuntType) == 4)  HVCU::DecodeCAN(id, data);
+        switch (Param::GetInt(Param::ShuntType))
+        {
+        case 1: ISA::DecodeCAN(id, data); break;
+        case 2: SBOX::DecodeCAN(id, data); break;
+        case 3: VWBOX::DecodeCAN(id, data); break;
+        case 4: HVCU::DecodeCAN(id, data); break;
+        }
 
         selectedInverter->DecodeCAN(id, data);
         selectedVehicle->DecodeCAN(id, data);
@@ -1337,19 +1988,25 @@ extern "C" int main(void)
 {
     extern const TERM_CMD TermCmds[];
 
+    BootProfile::Start();
+    MemStats::PaintStack();
+    BootProfile::Mark(BOOT_STACK);
     clock_setup();
+    BootProfile::Mark(BOOT_CLOCK);
     rtc_setup();
     ConfigureVariantIO();
     gpio_primary_remap(AFIO_MAPR_SWJ_CFG_JTAG_OFF_SW_ON, AFIO_MAPR_CAN2_REMAP | AFIO_MAPR_TIM1_REMAP_FULL_REMAP);//32f107
     usart2_setup();//TOYOTA HYBRID INVERTER INTERFACE
     nvic_setup();
+    IsrStats::Init();
+    MemStats::SetObjects(staticObjects, sizeof(staticObjects) / sizeof(staticObjects[0]));
+    BootProfile::Mark(BOOT_HWINIT);
     parm_load();
-    spi2_setup();
-    spi3_setup();
+    FaultLog::Init();
     tim3_setup(); //For general purpose PWM output
     Param::Change(Param::PARAM_LAST);
     DigIo::inv_out.Clear();//inverter power off during bootup
-    DigIo::mcp_sby.Clear();//enable can3
+    BootProfile::Mark(BOOT_PARAMS);
 
     Terminal t(USART3, TermCmds);
 
@@ -1365,7 +2022,8 @@ extern "C" int main(void)
     else {
         CanMapDev = &c2;
     }
-    CanMap cm(CanMapDev);
+    CanMapScheduler cms(CanMapDev);
+    CanMap cm(&cms);
     CanSdo sdo(&c, &cm);
     sdo.SetNodeId(3);//id 3 for vcu?
 
@@ -1376,25 +2034,18 @@ extern "C" int main(void)
     c2.AddCallback(&cb);
     TerminalCommands::SetCanMap(&cm);
     canMap = &cm;
+    canMapScheduler = &cms;
 
     CanHardware* shunt_can = canInterface[Param::GetInt(Param::ShuntCan)];
 
     canOBD2.SetCanInterface(canInterface[Param::GetInt(Param::OBD2Can)]);
+    BootProfile::Mark(BOOT_CAN);
 
-    CANSPI_Initialize();// init the MCP25625 on CAN3
-    CANSPI_ENRx_IRQ();  //init CAN3 Rx IRQ
-
-    LinBus l(USART1, 19200);
-    lin = &l;
+    //CAN3 and LIN are brought up in here if a selected device needs them
+    ReconfigureDevices();
+    BootProfile::Mark(BOOT_DEVICES);
 
-    UpdateInv();
-    UpdateVehicle();
-    UpdateCharger();
-    UpdateChargeInt();
-    UpdateBMS();
-    UpdateHeater();
-    UpdateDCDC();
-    UpdateShifter();
+    TaskWatchdog::Init();
 
     Stm32Scheduler s(TIM4); //We never exit main so it's ok to put it on stack
     scheduler = &s;
@@ -1403,12 +2054,18 @@ extern "C" int main(void)
     s.AddTask(Ms10Task, 10);
     s.AddTask(Ms100Task, 100);
     s.AddTask(Ms200Task, 200);
+    BootProfile::Mark(BOOT_SCHED);
+
+    //Nothing below is needed to get the vehicle ready, so the tasks are already running
+    spi3_setup(); //digi pots
+    digiPotsReady = true;
 
     if(Param::GetInt(Param::IsaInit)==1) ISA::initialize(shunt_can);//only call this once if a new sensor is fitted.
 
 
     Param::SetInt(Param::version, 4); //backward compatibility
     Param::SetInt(Param::opmode, MOD_OFF);//always off at startup
+    BootProfile::Finish();
 
     while(1)
     {
@@ -1418,6 +2075,19 @@ extern "C" int main(void)
         {
             TerminalCommands::PrintParamsJson(&sdo, &c);
         }
+
+        CanSdo::SdoFrame* sdoFrame = sdo.GetPendingUserspaceSdo();
+
+        if (0 != sdoFrame && BlackBox::ProcessSdo(sdoFrame))
+        {
+            sdo.SendSdoReply(sdoFrame);
+        }
+
+        BulkSdo::Run();
+        FaultLog::Run();
+        MemStats::Run();
+
+        if (LowPower::SleepRequested()) Sleep();
     }
 
     return 0;
@@ -20,7 +20,7 @@
 #include <libopencm3/stm32/timer.h>
 #include <libopencm3/stm32/gpio.h>
 #include "subaruvehicle.h"
-#include "anain.h"
+#include "anafilter.h"
 #include "my_math.h"
 
 #define IS_IN_RANGE(v, r)           (v < (r + 40) && v > (r - 40))
@@ -80,7 +80,7 @@ void SubaruVehicle::SetFuelGauge(float level)
 
 bool SubaruVehicle::GetGear(gear& gear)
 {
-    int gearsel = AnaIn::GP_analog2.Get();
+    int gearsel = AnaFilter::GP_analog2.Get();
 
     if (IS_GEARSEL_REVERSE(gearsel))
     {
@@ -102,7 +102,7 @@ bool SubaruVehicle::GetGear(gear& gear)
 int SubaruVehicle::GetCruiseState()
 {
     static int prevSel = 0;
-    int cruisesel = AnaIn::GP_analog1.Get();
+    int cruisesel = AnaFilter::GP_analog1.Get();
     int result = CC_NONE;
 
     if (IS_CC_RESUME(cruisesel))
@@ -131,7 +131,7 @@ int SubaruVehicle::GetCruiseState()
 float SubaruVehicle::GetFrontRearBalance()
 {
     static int prevSel = 0;
-    int sel = AnaIn::GP_analog2.Get();
+    int sel = AnaFilter::GP_analog2.Get();
 
     if (IS_GEARSEL_RESET_BALANCE(sel))
     {
@@ -156,7 +156,7 @@ float SubaruVehicle::GetFrontRearBalance()
 bool SubaruVehicle::EnableTractionControl()
 {
     static int prevSel = 0;
-    int sel = AnaIn::GP_analog2.Get();
+    int sel = AnaFilter::GP_analog2.Get();
 
     if (IS_GEARSEL_TCTOGGLE(sel) && IS_GEARSEL_NONE(prevSel))
     {
@@ -0,0 +1,128 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "taskwatchdog.h"
+#include "faultlog.h"
+#include "params.h"
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/iwdg.h>
+
+#define NOINIT_MAGIC 0x57444F47 //"GODW"
+
+//Feed() calls a task may miss before it counts as hung, the 200ms task runs every other call
+static const uint8_t maxAge[TaskWatchdog::TASK_LAST] = { 0, 1, 1, 1, 2 };
+
+TaskWatchdog::NoInitData TaskWatchdog::noInit __attribute__((section(".noinit")));
+volatile uint16_t TaskWatchdog::runCount[TASK_LAST];
+uint16_t TaskWatchdog::lastCount[TASK_LAST];
+uint8_t TaskWatchdog::age[TASK_LAST];
+
+void TaskWatchdog::Init()
+{
+    cause rstCause = GetResetCause();
+    task culprit = TASK_NONE;
+
+    if (noInit.magic != NOINIT_MAGIC || rstCause == RST_POWERON)
+    {
+        noInit.magic = NOINIT_MAGIC;
+        noInit.missing = 0;
+        noInit.resets = 0;
+        noInit.running = TASK_NONE;
+    }
+
+    if (rstCause == RST_WATCHDOG)
+    {
+        //A task that stopped running while the 100ms task kept feeding is the prime suspect.
+        //Otherwise whatever task was running blocked the scheduler.
+        for (int i = TASK_1MS; i < TASK_LAST; i++)
+        {
+            if (noInit.missing & (1 << i))
+            {
+                culprit = (task)i;
+                break;
+            }
+        }
+
+        if (culprit == TASK_NONE && noInit.running < TASK_LAST)
+            culprit = (task)noInit.running;
+
+        noInit.resets++;
+        FaultLog::Post(ERR_WATCHDOG);
+    }
+
+    Param::SetInt(Param::RstCause, rstCause);
+    Param::SetInt(Param::WdTask, culprit);
+
+    noInit.missing = 0;
+    noInit.running = TASK_NONE;
+
+    iwdg_set_period_ms(TASKWD_TIMEOUT_MS);
+    iwdg_start();
+    iwdg_reset();
+}
+
+void TaskWatchdog::Feed()
+{
+    uint8_t missing = 0;
+
+    for (int i = TASK_1MS; i < TASK_LAST; i++)
+    {
+        uint16_t count = runCount[i];
+
+        if (count != lastCount[i])
+        {
+            lastCount[i] = count;
+            age[i] = 0;
+        }
+        else if (age[i] < 255)
+        {
+            age[i]++;
+        }
+
+        if (age[i] >= maxAge[i])
+            missing |= 1 << i;
+    }
+
+    noInit.missing = missing;
+
+    if (0 == missing)
+        iwdg_reset();
+}
+
+TaskWatchdog::cause TaskWatchdog::GetResetCause()
+{
+    uint32_t csr = RCC_CSR;
+    cause rstCause = RST_UNKNOWN;
+
+    RCC_CSR |= RCC_CSR_RMVF;
+
+    //The reset pin flag is also set on internal resets, check it last
+    if (csr & RCC_CSR_IWDGRSTF)
+        rstCause = RST_WATCHDOG;
+    else if (csr & RCC_CSR_WWDGRSTF)
+        rstCause = RST_WWDG;
+    else if (csr & RCC_CSR_LPWRRSTF)
+        rstCause = RST_LOWPOWER;
+    else if (csr & RCC_CSR_SFTRSTF)
+        rstCause = RST_SOFTWARE;
+    else if (csr & RCC_CSR_PORRSTF)
+        rstCause = RST_POWERON;
+    else if (csr & RCC_CSR_PINRSTF)
+        rstCause = RST_PIN;
+
+    return rstCause;
+}
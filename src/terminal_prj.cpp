@@ -29,6 +29,14 @@
 #include "errormessage.h"
 #include "stm32_can.h"
 #include "terminalcommands.h"
+#include "blackbox.h"
+#include "faultlog.h"
+#include "isrstats.h"
+#include "memstats.h"
+#include "bootprofile.h"
+#include "contactorseq.h"
+#include "sequence.h"
+#include "linmaster.h"
 
 static void LoadDefaults(Terminal* t, char *arg);
 static void GetAll(Terminal* t, char *arg);
@@ -36,6 +44,14 @@ static void PrintList(Terminal* t, char *arg);
 static void PrintAtr(Terminal* t, char *arg);
 static void PrintSerial(Terminal* t, char *arg);
 static void PrintErrors(Terminal* t, char *arg);
+static void PrintBlackBox(Terminal* t, char *arg);
+static void PrintFaults(Terminal* t, char *arg);
+static void PrintIsrStats(Terminal* t, char *arg);
+static void PrintMemStats(Terminal* t, char *arg);
+static void PrintBootProfile(Terminal* t, char *arg);
+static void PrintContactorLog(Terminal* t, char *arg);
+static void PrintSequences(Terminal* t, char *arg);
+static void PrintLinStats(Terminal* t, char *arg);
 
 extern const TERM_CMD TermCmds[] =
 {
@@ -53,6 +69,14 @@ extern const TERM_CMD TermCmds[] =
    { "can", TerminalCommands::MapCan },
    { "serial", PrintSerial },
    { "errors", PrintErrors },
+   { "blackbox", PrintBlackBox },
+   { "faults", PrintFaults },
+   { "isr", PrintIsrStats },
+   { "mem", PrintMemStats },
+   { "boot", PrintBootProfile },
+   { "contactors", PrintContactorLog },
+   { "sequences", PrintSequences },
+   { "lin", PrintLinStats },
    { "reset", TerminalCommands::Reset },
    { NULL, NULL }
 };
@@ -129,3 +153,84 @@ static void PrintSerial(Terminal* t, char *arg)
    arg = arg;
    fprintf(t, "%X%X%X\r\n", DESIG_UNIQUE_ID2, DESIG_UNIQUE_ID1, DESIG_UNIQUE_ID0);
 }
+
+static void PrintBlackBox(Terminal* t, char *arg)
+{
+   arg = my_trim(arg);
+
+   if (0 == my_strcmp(arg, "arm"))
+   {
+      BlackBox::Arm();
+      fprintf(t, "Black box armed\r\n");
+   }
+   else
+   {
+      BlackBox::Print(t);
+   }
+}
+
+static void PrintFaults(Terminal* t, char *arg)
+{
+   arg = my_trim(arg);
+
+   if (0 == my_strcmp(arg, "clear"))
+   {
+      if (FaultLog::Clear())
+         fprintf(t, "Fault history cleared\r\n");
+      else
+         fprintf(t, "Only possible in opmode off\r\n");
+   }
+   else
+   {
+      FaultLog::Print(t);
+   }
+}
+
+static void PrintIsrStats(Terminal* t, char *arg)
+{
+   arg = my_trim(arg);
+
+   if (0 == my_strcmp(arg, "reset"))
+   {
+      IsrStats::Reset();
+      fprintf(t, "Interrupt statistics reset\r\n");
+   }
+   else
+   {
+      IsrStats::Print(t);
+   }
+}
+
+static void PrintMemStats(Terminal* t, char *arg)
+{
+   arg = arg;
+   MemStats::Print(t);
+}
+
+static void PrintBootProfile(Terminal* t, char *arg)
+{
+   arg = arg;
+   BootProfile::Print(t);
+}
+
+static void PrintContactorLog(Terminal* t, char *arg)
+{
+   const ContactorSeq::LogEntry* e;
+   arg = arg;
+
+   fprintf(t, "topology,opmode,step,ms\r\n");
+   for (int i = 0; (e = ContactorSeq::GetLog(i)) != 0; i++)
+      fprintf(t, "%u,%u,%u,%u\r\n", e->topology, e->opmode, e->step, e->ms);
+}
+
+static void PrintSequences(Terminal* t, char *arg)
+{
+   arg = arg;
+   Sequence::Print(t);
+}
+
+static void PrintLinStats(Terminal* t, char *arg)
+{
+   arg = arg;
+   LinMaster::Print(t);
+}
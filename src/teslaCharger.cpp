@@ -22,6 +22,7 @@
 #include "my_math.h"
 
 static bool ChRun = false;
+static bool stopSent = false; //0W has been commanded since ChRun went false
 
 static uint8_t grid_config = 0;
 static float AC_line_voltage = 0;
@@ -107,11 +108,18 @@ void teslaCharger::Task100Ms()
    bytes[6] = ((HVpwr & 0xFF00) >> 8);
    bytes[7] = (ChRun ? (0xA << 4) : (0xC << 4)) | (currentLimit & 0xF);
    can->Send(0x109, (uint32_t*)bytes, 8);
+   stopSent = !ChRun;
 }
 
 bool teslaCharger::ControlCharge(bool RunCh, bool ACReq)
 {
    (void)RunCh;
    ChRun = ACReq;
+   if (ChRun) stopSent = false;
    return ACReq;
+}
+
+bool teslaCharger::IsIdle()
+{
+   return stopSent;
 }
\ No newline at end of file
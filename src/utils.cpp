@@ -30,6 +30,8 @@
 #include <libopencm3/stm32/timer.h>
 #include <libopencm3/stm32/rtc.h>
 #include "hwinit.h"
+#include "blackbox.h"
+#include "faultlog.h"
 
 namespace utils
 {
@@ -45,7 +47,7 @@ void PostErrorIfRunning(ERROR_MESSAGE_NUM err)
 {
     if (Param::GetInt(Param::opmode) == MOD_RUN)
     {
-        ErrorMessage::Post(err);
+        FaultLog::Post(err);
     }
 }
 
@@ -60,7 +62,8 @@ void GetDigInputs(CanHardware* can)
     {
         canio = 0;
         Param::SetInt(Param::canio, 0);
-        ErrorMessage::Post(ERR_CANTIMEOUT);
+        FaultLog::Post(ERR_CANTIMEOUT);
+        BlackBox::Trigger(BlackBox::TRG_CANTIMEOUT);
     }
 
     Param::SetInt(Param::din_cruise, ((canio & CAN_IO_CRUISE) != 0));
@@ -88,14 +91,14 @@ void GetDigInputs(CanHardware* can)
  *
  * @return float Throttle percentage in the range of [-100.0, 100.0]
  */
-float GetUserThrottleCommand()
+float GetUserThrottleCommand(const TickParams& t)
 {
-    bool brake = Param::GetBool(Param::din_brake);
-    int potmode = Param::GetInt(Param::potmode);
-    int direction = Param::GetInt(Param::dir);
+    bool brake = t.brake;
+    int potmode = t.potmode;
+    int direction = t.dir;
 
-    int pot1val = AnaIn::throttle1.Get();
-    int pot2val = AnaIn::throttle2.Get();
+    int pot1val = AnaFilter::throttle1.Get();
+    int pot2val = AnaFilter::throttle2.Get();
     Param::SetInt(Param::pot, pot1val);
     Param::SetInt(Param::pot2, pot2val);
 
@@ -288,19 +291,19 @@ void SelectDirection(Vehicle* vehicle, Shifter* shifter)
     Param::SetInt(Param::dir, selectedDir);
 }
 
-float ProcessUdc(int motorSpeed)
+float ProcessUdc(const TickParams& t)
 {
-    float udc = Param::GetFloat(Param::udc);
+    float udc = t.udc;
 
-    if (Param::GetInt(Param::ShuntType) == 0)
+    if (t.shuntType == 0)
     {
         //This way we can have ShuntType 0 and still pull latests info
-        if(Param::GetInt(Param::opmode) == MOD_OFF)
+        if(t.opmode == MOD_OFF)
         {
             udc = 0; //ensure we reset udc during off state to keep precharge working
         }
     }
-    else if (Param::GetInt(Param::ShuntType) == 1)//ISA shunt
+    else if (t.shuntType == 1)//ISA shunt
     {
         float udc = ((float)ISA::Voltage)/1000;//get voltage from isa sensor and post to parameter database
         Param::SetFloat(Param::udc, udc);
@@ -320,7 +323,7 @@ float ProcessUdc(int motorSpeed)
         float deltaVolts2 = (udc2 + udc3) - udc;
         Param::SetFloat(Param::deltaV, MAX(deltaVolts1, deltaVolts2));
     }
-    else if (Param::GetInt(Param::ShuntType) == 2)//BMs Sbox
+    else if (t.shuntType == 2)//BMs Sbox
     {
         float udc = ((float)SBOX::Voltage2)/1000;//get output voltage from sbox sensor and post to parameter database
         Param::SetFloat(Param::udc, udc);
@@ -334,7 +337,7 @@ float ProcessUdc(int motorSpeed)
         float kw = (udc*idc)/1000;//get power from isa sensor and post to parameter database
         Param::SetFloat(Param::power, kw);
     }
-    else if (Param::GetInt(Param::ShuntType) == 3)//VW
+    else if (t.shuntType == 3)//VW
     {
         float udc = ((float)VWBOX::Voltage)*0.5;//get output voltage from sbox sensor and post to parameter database
         Param::SetFloat(Param::udc, udc);
@@ -352,13 +355,11 @@ float ProcessUdc(int motorSpeed)
     //1.2/(4.7+1.2)/3.33*4095 = 250 -> make it a bit less for pin losses etc
     //HW_REV1 had 3.9k resistors
     int uauxGain = 210; //!! hard coded AUX gain
-    Param::SetFloat(Param::uaux, ((float)AnaIn::uaux.Get()) / uauxGain);
+    Param::SetFloat(Param::uaux, ((float)AnaFilter::uaux.Get()) / uauxGain);
 
-    float udclim = Param::GetFloat(Param::udclim);
-
-    if (udc > udclim)
+    if (udc > t.udclim)
     {
-        if (ABS(motorSpeed) < 50) //If motor is stationary, over voltage comes from outside
+        if (ABS(t.speed) < 50) //If motor is stationary, over voltage comes from outside
         {
             DigIo::dcsw_out.Clear();  //In this case, open DC switch
             DigIo::prec_out.Clear();  //and
@@ -366,7 +367,8 @@ float ProcessUdc(int motorSpeed)
         }
 
         Param::SetInt(Param::opmode, MOD_OFF);
-        ErrorMessage::Post(ERR_OVERVOLTAGE);
+        FaultLog::Post(ERR_OVERVOLTAGE);
+        BlackBox::Trigger(BlackBox::TRG_OVERVOLTAGE);
     }
     /*
        if(opmode == MOD_PRECHARGE)
@@ -374,7 +376,7 @@ float ProcessUdc(int motorSpeed)
           if (udc < (udcsw) && rtc_get_counter_val() > (oldTime + PRECHARGE_TIMEOUT) && DigIo::prec_out.Get())
           {
              DigIo::prec_out.Clear();
-             ErrorMessage::Post(ERR_PRECHARGE);
+             FaultLog::Post(ERR_PRECHARGE);
              Param::SetInt(Param::opmode, MOD_PCHFAIL);
           }
        }
@@ -382,9 +384,10 @@ float ProcessUdc(int motorSpeed)
     return udc;
 }
 
-float ProcessThrottle(int speed)
+float ProcessThrottle(const TickParams& t)
 {
     float finalSpnt;
+    int speed = ABS(t.speed);
 
     if (speed < Param::GetInt(Param::throtramprpm))
     {
@@ -396,7 +399,7 @@ float ProcessThrottle(int speed)
         Throttle::throttleRamp = Param::GetAttrib(Param::throtramp)->max;
     }
 
-    finalSpnt = utils::GetUserThrottleCommand();
+    finalSpnt = utils::GetUserThrottleCommand(t);
 
     /* No Cruise allowed
     if (Param::Get(Param::cruisespeed) > 0)
@@ -411,18 +414,18 @@ float ProcessThrottle(int speed)
 */
     //finalSpnt = Throttle::RampThrottle(finalSpnt); //OLD - Throttle ramping reorganised in V2.30A
 
-    Throttle::UdcLimitCommand(finalSpnt,Param::GetFloat(Param::udc));
-    Throttle::IdcLimitCommand(finalSpnt, ABS(Param::GetFloat(Param::idc)));
-    Throttle::SpeedLimitCommand(finalSpnt, ABS(speed));
+    Throttle::UdcLimitCommand(finalSpnt, t.udc);
+    Throttle::IdcLimitCommand(finalSpnt, ABS(t.idc));
+    Throttle::SpeedLimitCommand(finalSpnt, speed);
 
-    if (Throttle::TemperatureDerate(Param::Get(Param::tmphs), Param::Get(Param::tmphsmax), finalSpnt))
+    if (Throttle::TemperatureDerate(t.tmphs, t.tmphsmax, finalSpnt))
     {
-        ErrorMessage::Post(ERR_TMPHSMAX);
+        FaultLog::Post(ERR_TMPHSMAX);
     }
 
-    if (Throttle::TemperatureDerate(Param::Get(Param::tmpm), Param::Get(Param::tmpmmax), finalSpnt))
+    if (Throttle::TemperatureDerate(t.tmpm, t.tmpmmax, finalSpnt))
     {
-        ErrorMessage::Post(ERR_TMPMMAX);
+        FaultLog::Post(ERR_TMPMMAX);
     }
 
     finalSpnt = Throttle::RampThrottle(finalSpnt); //Move ramping as last step -intro V2.30A
@@ -444,11 +447,11 @@ float ProcessThrottle(int speed)
     //                                                                                  //
     //----------------------------------------------------------------------------------//
     
-    float udc = Param::GetFloat(Param::udc);
-    float idc = ABS(Param::GetFloat(Param::idc));  // Use ABS for derate calc; adjust if idcMotor used
-    float temp_hs = Param::Get(Param::tmphs);
-    float temp_m = Param::Get(Param::tmpm);
-    int abs_speed = ABS(speed);
+    float udc = t.udc;
+    float idc = ABS(t.idc);  // Use ABS for derate calc; adjust if idcMotor used
+    float temp_hs = t.tmphs;
+    float temp_m = t.tmpm;
+    int abs_speed = speed;
 
     float discharge_factor = Throttle::GetDischargeDerateFactor(udc, idc, temp_hs, temp_m, abs_speed);
     float derated_discharge_current = Param::GetFloat(Param::idcmax) * discharge_factor;
@@ -464,8 +467,8 @@ float ProcessThrottle(int speed)
 
 void displayThrottle()
 {
-    uint16_t potdisp = AnaIn::throttle1.Get();
-    uint16_t pot2disp = AnaIn::throttle2.Get();
+    uint16_t potdisp = AnaFilter::throttle1.Get();
+    uint16_t pot2disp = AnaFilter::throttle2.Get();
     Param::SetInt(Param::pot, potdisp);
     Param::SetInt(Param::pot2, pot2disp);
 }
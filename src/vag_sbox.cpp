@@ -72,7 +72,7 @@ void VWBOX::handle0BB(uint32_t data[2])  //VWBOX Current and voltages
 
 
 
-void VWBOX::ControlContactors(int opmode, CanHardware* can)
+void VWBOX::ControlContactors(uint8_t contactors, CanHardware* can)
 {
    uint8_t bytes[8];
    Sec1tmr++;
@@ -95,33 +95,9 @@ void VWBOX::ControlContactors(int opmode, CanHardware* can)
 
 
 
-      switch (opmode)
-   {
-      case 0:
-       bytes[2]=0x28;//all contactors off
-       bytes[1]=bytes[1] | 0x00;
-         break;
-      case 2://Precharge
-       bytes[2]=bytes[2] | 0x1;;//Neg on
-       bytes[1]=bytes[1] | 0x10;//Prech on
-         break;
-
-      case 1://Run
-       bytes[2]=bytes[2] | 0x1;;//Neg on
-       bytes[1]=bytes[1] | 0x50;//main on and prech on
-         break;
-
-      case 4://Charge
-       bytes[2]=bytes[2] | 0x1;;//Neg on
-       bytes[1]=bytes[1] | 0x50;//main on and prech on
-         break;
-
-      case 3://Precharge fail
-       bytes[2]=0x28;//all contactors off
-       bytes[1]=bytes[1] | 0x00;
-         break;
-
-    }
+   if (contactors & ContactorSeq::CT_NEGATIVE) bytes[2]=bytes[2] | 0x1;//Neg on
+   if (contactors & ContactorSeq::CT_PRECHARGE) bytes[1]=bytes[1] | 0x10;//Prech on
+   if (contactors & ContactorSeq::CT_MAIN) bytes[1]=bytes[1] | 0x40;//main on
    bytes[0]=vw_crc_calc(bytes);
    can->Send(0x0BA, (uint32_t*)bytes,8);
    vag_cnt0ba++;
@@ -0,0 +1,175 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include "test_list.h"
+#include "anafilter.h"
+
+using namespace std;
+
+#define NOISE       8    //LSB rms left after the AnaIn average
+#define SPIKE_RATE  200  //one in this many samples is a spike to full scale
+
+//ADC reading of a signal with gaussian noise and the odd spike
+struct Input
+{
+    float signal;
+    float noise;
+    bool spikes;
+    uint32_t seed;
+    uint32_t count;
+
+    float Uniform()
+    {
+        seed = seed * 1103515245 + 12345;
+        return (((seed >> 8) & 0xFFFF) + 0.5f) / 65536.0f;
+    }
+
+    uint16_t Sample()
+    {
+        float n = noise * sqrtf(-2 * logf(Uniform())) * cosf(6.2831853f * Uniform());
+        float v = signal + n;
+
+        if (spikes && (++count % SPIKE_RATE) == 0) v = 4095;
+        if (v < 0) v = 0;
+        if (v > 4095) v = 4095;
+        return v;
+    }
+};
+
+struct Stats
+{
+    float mean;
+    float rms;       //deviation from the signal
+    uint32_t results;
+    uint32_t minSpacing, maxSpacing;
+};
+
+//Runs the filter for the given time at the ANAFILTER_PERIOD_MS tick, like Run() does
+static Stats Simulate(AnaFilter& f, Input& in, uint32_t& now, uint32_t ms)
+{
+    Stats s = { 0, 0, 0, 0xFFFFFFFF, 0 };
+    uint32_t lastTime = f.GetTime();
+    float sum = 0, sumSq = 0;
+
+    for (uint32_t end = now + ms; now < end;)
+    {
+        now += ANAFILTER_PERIOD_MS;
+        if (f.Due()) f.Sample(in.Sample(), now);
+
+        if (f.GetTime() != lastTime)
+        {
+            uint32_t spacing = f.GetTime() - lastTime;
+            float err = f.Get() - in.signal;
+
+            if (spacing < s.minSpacing) s.minSpacing = spacing;
+            if (spacing > s.maxSpacing) s.maxSpacing = spacing;
+            lastTime = f.GetTime();
+            sum += f.Get();
+            sumSq += err * err;
+            s.results++;
+        }
+    }
+
+    if (s.results > 0)
+    {
+        s.mean = sum / s.results;
+        s.rms = sqrtf(sumSq / s.results);
+    }
+    return s;
+}
+
+//Time until the output is more than half way to a step of the input
+static uint32_t StepLatency(AnaFilter& f, Input& in, uint32_t& now, float to)
+{
+    float from = in.signal;
+    uint32_t start = now;
+
+    in.signal = to;
+    while (now - start < 10000)
+    {
+        now += ANAFILTER_PERIOD_MS;
+        if (f.Due()) f.Sample(in.Sample(), now);
+        if (fabsf(f.Get() - from) > fabsf(to - from) / 2) break;
+    }
+    return now - start;
+}
+
+static void TestFirstSamplePublished()
+{
+    AnaFilter f(10, 5, 10);
+
+    ASSERT(f.Due() == false);
+    for (int i = 0; i < 9; i++) f.Due();
+    f.Sample(1234, 10);
+    ASSERT(f.Get() == 1234 && f.GetTime() == 10);
+}
+
+static void TestPedalRateAndLatency()
+{
+    AnaFilter f(1, 3, 1);
+    Input in = { 500, NOISE, false, 1, 0 };
+    uint32_t now = 0;
+    Stats s = Simulate(f, in, now, 1000);
+
+    //1kHz results, noise slightly reduced by the median
+    ASSERT(s.results == 1000 && s.minSpacing == 1 && s.maxSpacing == 1);
+    ASSERT(s.rms < NOISE);
+    //The median of 3 delays a step by one sample
+    ASSERT(StepLatency(f, in, now, 3000) <= 2);
+}
+
+static void TestSpikesRejected()
+{
+    AnaFilter f(1, 3, 1);
+    Input in = { 1000, 0, true, 1, 0 };
+    uint32_t now = 0;
+    uint16_t maxValue = 0;
+
+    for (int i = 0; i < 5000; i++)
+    {
+        now++;
+        if (f.Due()) f.Sample(in.Sample(), now);
+        if (f.Get() > maxValue) maxValue = f.Get();
+    }
+    ASSERT(maxValue == 1000);
+}
+
+static void TestTemperatureRateAndNoise()
+{
+    AnaFilter f(10, 5, 10);
+    Input in = { 2000, NOISE, true, 7, 0 };
+    uint32_t now = 0;
+
+    Simulate(f, in, now, 1000); //settle
+    Stats s = Simulate(f, in, now, 10000);
+
+    //10Hz results, spikes gone and noise down to about a third
+    ASSERT(s.results == 100 && s.minSpacing == 100 && s.maxSpacing == 100);
+    ASSERT(fabsf(s.mean - 2000) < 1);
+    ASSERT(s.rms < NOISE / 3.0f);
+    //Up to one result period plus the median delay
+    ASSERT(StepLatency(f, in, now, 1000) <= 130);
+}
+
+void AnaFilterTest::RunTest()
+{
+    TestFirstSamplePublished();
+    TestPedalRateAndLatency();
+    TestSpikesRejected();
+    TestTemperatureRateAndNoise();
+}
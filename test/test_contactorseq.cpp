@@ -0,0 +1,153 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_list.h"
+#include "contactorseq.h"
+#include "params.h"
+
+using namespace std;
+
+typedef ContactorSeq CS;
+
+//Runs the sequence for ms milliseconds, returns the outputs of the last period
+static uint8_t RunFor(CS& seq, int opmode, uint32_t ms, uint8_t conditions = CS::CTC_CURRENT_LOW)
+{
+    uint8_t outputs = 0;
+
+    for (uint32_t t = 0; t < ms; t += CTS_PERIOD_MS)
+      outputs = seq.Run(opmode, conditions);
+
+    return outputs;
+}
+
+static void TestLocalPrechargeDelaysPrechargeRelay()
+{
+    CS seq(CS::TOP_LOCAL);
+    ASSERT(RunFor(seq, MOD_PRECHARGE, 250) == CS::CT_NEGATIVE && !seq.IsDone());
+    ASSERT(RunFor(seq, MOD_PRECHARGE, 10) == (CS::CT_NEGATIVE | CS::CT_PRECHARGE) && seq.IsDone());
+}
+
+static void TestNoNegativeContactorPrechargesAtOnce()
+{
+    CS seq(CS::TOP_LOCAL_NONEG);
+    ASSERT(RunFor(seq, MOD_PRECHARGE, 10) == (CS::CT_NEGATIVE | CS::CT_PRECHARGE) && seq.IsDone());
+}
+
+static void TestLocalRunAndCharge()
+{
+    CS seq(CS::TOP_LOCAL);
+    RunFor(seq, MOD_PRECHARGE, 500);
+    ASSERT(RunFor(seq, MOD_RUN, 250) == (CS::CT_NEGATIVE | CS::CT_PRECHARGE));
+    ASSERT(RunFor(seq, MOD_RUN, 10) == CS::CT_ALL && seq.IsDone());
+
+    CS charge(CS::TOP_LOCAL);
+    RunFor(charge, MOD_PRECHARGE, 500);
+    ASSERT(RunFor(charge, MOD_CHARGE, 5000) == (CS::CT_NEGATIVE | CS::CT_PRECHARGE));
+    ASSERT(RunFor(charge, MOD_CHARGE, 10) == CS::CT_ALL);
+}
+
+static void TestChargeToRunKeepsMainClosed()
+{
+    CS seq(CS::TOP_LOCAL);
+    RunFor(seq, MOD_PRECHARGE, 500);
+    RunFor(seq, MOD_CHARGE, 6000);
+    ASSERT(seq.Run(MOD_RUN, CS::CTC_NONE) == CS::CT_ALL && seq.IsDone());
+}
+
+static void TestShutdownWaitsForCurrent()
+{
+    CS seq(CS::TOP_LOCAL);
+    RunFor(seq, MOD_RUN, 500);
+    ASSERT(RunFor(seq, MOD_SHUTDOWN_REQUEST, 2000, CS::CTC_NONE) == CS::CT_ALL && !seq.IsDone());
+    ASSERT(RunFor(seq, MOD_SHUTDOWN_REQUEST, 10) == CS::CT_ALL && seq.IsDone());
+}
+
+static void TestOffAfterShutdownHoldsContactors()
+{
+    CS seq(CS::TOP_LOCAL);
+    RunFor(seq, MOD_RUN, 500);
+    RunFor(seq, MOD_SHUTDOWN_REQUEST, 1600);
+    ASSERT(RunFor(seq, MOD_OFF, 2500) == CS::CT_ALL);
+    ASSERT(RunFor(seq, MOD_OFF, 10) == 0 && seq.IsDone());
+}
+
+static void TestIdleDevicesEndShutdownEarly()
+{
+    const uint8_t idle = CS::CTC_CURRENT_LOW | CS::CTC_DEVICES_IDLE;
+    CS seq(CS::TOP_LOCAL);
+    RunFor(seq, MOD_RUN, 500);
+    ASSERT(RunFor(seq, MOD_SHUTDOWN_REQUEST, 10, CS::CTC_DEVICES_IDLE) == CS::CT_ALL && !seq.IsDone());
+    ASSERT(RunFor(seq, MOD_SHUTDOWN_REQUEST, 10, idle) == CS::CT_ALL && seq.IsDone());
+    ASSERT(RunFor(seq, MOD_OFF, 10, idle) == 0);
+}
+
+static void TestFailureOpensImmediately()
+{
+    CS seq(CS::TOP_LOCAL);
+    RunFor(seq, MOD_PRECHARGE, 500);
+    ASSERT(RunFor(seq, MOD_PCHFAIL, 10) == CS::CT_NEGATIVE);
+    ASSERT(RunFor(seq, MOD_OFF, 10) == 0);
+}
+
+static void TestBoxes()
+{
+    CS sbox(CS::TOP_SBOX);
+    ASSERT(RunFor(sbox, MOD_PRECHARGE, 10) == (CS::CT_NEGATIVE | CS::CT_PRECHARGE));
+    ASSERT(RunFor(sbox, MOD_RUN, 10) == CS::CT_ALL);
+    ASSERT(RunFor(sbox, MOD_SHUTDOWN_REQUEST, 10, CS::CTC_NONE) == CS::CT_ALL);
+    ASSERT(RunFor(sbox, MOD_OFF, 10) == 0);
+
+    CS hvcu(CS::TOP_HVCU);
+    ASSERT(RunFor(hvcu, MOD_PRECHARGE, 10) == (CS::CT_NEGATIVE | CS::CT_PRECHARGE));
+    ASSERT(RunFor(hvcu, MOD_CHARGE, 10) == (CS::CT_NEGATIVE | CS::CT_MAIN));
+    ASSERT(RunFor(hvcu, MOD_PCHFAIL, 10) == 0);
+}
+
+static void TestTopologyChangeTakesEffectOnNextMode()
+{
+    CS seq(CS::TOP_LOCAL);
+    RunFor(seq, MOD_PRECHARGE, 100);
+    seq.SetTopology(CS::TOP_HVCU);
+    ASSERT(RunFor(seq, MOD_PRECHARGE, 10) == CS::CT_NEGATIVE);
+    ASSERT(RunFor(seq, MOD_RUN, 10) == (CS::CT_NEGATIVE | CS::CT_MAIN));
+}
+
+static void TestLogHasCompletedSteps()
+{
+    CS seq(CS::TOP_LOCAL);
+    RunFor(seq, MOD_PRECHARGE, 300);
+    const CS::LogEntry* e = CS::GetLog(0);
+    ASSERT(e != 0 && e->opmode == MOD_PRECHARGE && e->step == 1 && e->ms == 0);
+    e = CS::GetLog(1);
+    ASSERT(e != 0 && e->opmode == MOD_PRECHARGE && e->step == 0 && e->ms == 250);
+    ASSERT(CS::GetLog(CTS_LOG_SIZE) == 0);
+}
+
+void ContactorSeqTest::RunTest()
+{
+    TestLocalPrechargeDelaysPrechargeRelay();
+    TestNoNegativeContactorPrechargesAtOnce();
+    TestLocalRunAndCharge();
+    TestChargeToRunKeepsMainClosed();
+    TestShutdownWaitsForCurrent();
+    TestOffAfterShutdownHoldsContactors();
+    TestIdleDevicesEndShutdownEarly();
+    TestFailureOpensImmediately();
+    TestBoxes();
+    TestTopologyChangeTakesEffectOnNextMode();
+    TestLogHasCompletedSteps();
+}
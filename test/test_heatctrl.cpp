@@ -0,0 +1,214 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_list.h"
+#include "heatctrl.h"
+
+using namespace std;
+
+#define KP          300
+#define KI          1
+#define RAMP        1000
+#define MAXPOWER    6000
+#define TARGET      50
+#define HYST        5    //bang-bang hysteresis, same as the preheat demand
+#define DEADTIME    150  //transport delay around the loop in HEATCTRL_PERIOD_MS steps
+
+//Coolant loop as a single thermal mass losing heat to the cabin, seen through a delayed sensor
+struct Coolant
+{
+    float temp;
+    float ambient;
+    float capacity;   //J/K
+    float loss;       //W/K
+    float delayed[DEADTIME];
+    int pos;
+
+    void Init(float t)
+    {
+        temp = t;
+        ambient = 0;
+        capacity = 20000;
+        loss = 50;
+        pos = 0;
+        for (int i = 0; i < DEADTIME; i++) delayed[i] = t;
+    }
+
+    float Sensor() { return delayed[pos]; }
+
+    void Step(int32_t power)
+    {
+        temp += (power - loss * (temp - ambient)) * (HEATCTRL_PERIOD_MS / 1000.0f) / capacity;
+        delayed[pos] = temp;
+        pos = (pos + 1) % DEADTIME;
+    }
+};
+
+struct Result
+{
+    float maxTemp;
+    float finalTemp;
+    uint32_t energy;
+};
+
+//Warms the loop from ambient for the given time with the PI controller
+static Result RunPi(int seconds, int32_t maxPower)
+{
+    Coolant c;
+    Result r = { 0, 0, HeatCtrl::GetEnergy() };
+
+    c.Init(0);
+    HeatCtrl::SetParams(KP, KI, RAMP);
+    HeatCtrl::Reset();
+
+    for (int i = 0; i < seconds * 1000 / HEATCTRL_PERIOD_MS; i++)
+    {
+        c.Step(HeatCtrl::Run(c.Sensor(), TARGET, maxPower));
+        if (c.temp > r.maxTemp) r.maxTemp = c.temp;
+    }
+    r.finalTemp = c.temp;
+    r.energy = HeatCtrl::GetEnergy() - r.energy;
+    return r;
+}
+
+//Full power below TARGET - HYST until TARGET is reached
+static Result RunBangBang(int seconds)
+{
+    Coolant c;
+    Result r = { 0, 0, HeatCtrl::GetEnergy() };
+    bool on = true;
+
+    c.Init(0);
+    HeatCtrl::SetParams(0, 0, 0);
+    HeatCtrl::Reset();
+
+    for (int i = 0; i < seconds * 1000 / HEATCTRL_PERIOD_MS; i++)
+    {
+        float t = c.Sensor();
+
+        if (t >= TARGET) on = false;
+        if (t < TARGET - HYST) on = true;
+        c.Step(HeatCtrl::Run(t, TARGET, on ? MAXPOWER : 0));
+        if (c.temp > r.maxTemp) r.maxTemp = c.temp;
+    }
+    r.finalTemp = c.temp;
+    r.energy = HeatCtrl::GetEnergy() - r.energy;
+    return r;
+}
+
+static void TestSettlesAtTarget()
+{
+    Result r = RunPi(3600, MAXPOWER);
+    ASSERT(r.finalTemp > TARGET - 0.5f && r.finalTemp < TARGET + 0.5f);
+    ASSERT(r.maxTemp < TARGET + 1);
+}
+
+static void TestRiseIsRateLimited()
+{
+    Coolant c;
+    int32_t last = 0;
+    bool limited = true;
+
+    c.Init(0);
+    HeatCtrl::SetParams(KP, KI, RAMP);
+    HeatCtrl::Reset();
+
+    for (int i = 0; i < 200; i++)
+    {
+        int32_t p = HeatCtrl::Run(c.Sensor(), TARGET, MAXPOWER);
+        limited &= p - last <= RAMP * HEATCTRL_PERIOD_MS / 1000;
+        last = p;
+        c.Step(p);
+    }
+    ASSERT(limited && last == MAXPOWER);
+
+    //Dropping the request is immediate
+    ASSERT(HeatCtrl::Run(TARGET + 20, TARGET, MAXPOWER) == 0);
+}
+
+static void TestNoWindupWhileSaturated()
+{
+    Coolant c;
+    float maxTemp = 0;
+
+    c.Init(0);
+    HeatCtrl::SetParams(KP, KI, RAMP);
+    HeatCtrl::Reset();
+
+    //1500 W only hold 30°C, the controller sits at its limit for half an hour
+    for (int i = 0; i < 18000; i++)
+        c.Step(HeatCtrl::Run(c.Sensor(), TARGET, 1500));
+
+    ASSERT(HeatCtrl::GetDuty() == 100);
+
+    for (int i = 0; i < 36000; i++)
+    {
+        c.Step(HeatCtrl::Run(c.Sensor(), TARGET, MAXPOWER));
+        if (c.temp > maxTemp) maxTemp = c.temp;
+    }
+    ASSERT(maxTemp < TARGET + 1);
+    ASSERT(c.temp > TARGET - 0.5f && c.temp < TARGET + 0.5f);
+}
+
+static void TestLessOvershootThanBangBang()
+{
+    Result pi = RunPi(3600, MAXPOWER);
+    Result bb = RunBangBang(3600);
+
+    ASSERT(pi.maxTemp + 2 < bb.maxTemp);
+    //Fixed power as before would have used MAXPOWER Wh in that hour
+    ASSERT(pi.energy < MAXPOWER / 2);
+}
+
+static void TestOpenLoopAndEnergy()
+{
+    uint32_t start = HeatCtrl::GetEnergy();
+
+    HeatCtrl::SetParams(0, 0, 0);
+    HeatCtrl::Reset();
+
+    //3600 W for one hour
+    for (int i = 0; i < 3600 * 1000 / HEATCTRL_PERIOD_MS; i++)
+        ASSERT(HeatCtrl::Run(80, TARGET, 3600) == 3600);
+
+    ASSERT(HeatCtrl::GetEnergy() - start == 3600);
+    ASSERT(HeatCtrl::GetDuty() == 100);
+}
+
+static void TestRunOpenLoopIgnoresGains()
+{
+    int32_t p = 0;
+
+    HeatCtrl::SetParams(KP, KI, RAMP);
+    HeatCtrl::Reset();
+
+    //Ramps to the limit like Run() with both gains at 0, there is no temperature to regulate on
+    for (int i = 0; i < 60 && p < MAXPOWER; i++)
+        p = HeatCtrl::RunOpenLoop(MAXPOWER);
+
+    ASSERT(p == MAXPOWER && HeatCtrl::GetDuty() == 100);
+}
+
+void HeatCtrlTest::RunTest()
+{
+    TestSettlesAtTarget();
+    TestRiseIsRateLimited();
+    TestNoWindupWhileSaturated();
+    TestLessOvershootThanBangBang();
+    TestOpenLoopAndEnergy();
+    TestRunOpenLoopIgnoresGains();
+}
@@ -29,10 +29,38 @@ class ThrottleTest: public IUnitTest
       virtual void RunTest();
 };
 
+class PrechargeTest: public IUnitTest
+{
+   public:
+      virtual void RunTest();
+};
+
+class ContactorSeqTest: public IUnitTest
+{
+   public:
+      virtual void RunTest();
+};
+
+class HeatCtrlTest: public IUnitTest
+{
+   public:
+      virtual void RunTest();
+};
+
+class AnaFilterTest: public IUnitTest
+{
+   public:
+      virtual void RunTest();
+};
+
 #ifdef EXPORT_TESTLIST
 IUnitTest* testList[] =
 {
    new ThrottleTest(),
+   new PrechargeTest(),
+   new ContactorSeqTest(),
+   new HeatCtrlTest(),
+   new AnaFilterTest(),
    NULL
 };
 #endif
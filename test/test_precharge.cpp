@@ -0,0 +1,175 @@
+/*
+ * This file is part of the ZombieVerter project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include "test_list.h"
+#include "precharge.h"
+
+using namespace std;
+
+#define TIMEOUT_MS  2000
+#define TOL         10
+#define UDCSW       330
+#define TAU_MIN_MS  10
+#define RLYDLY_MS   250 //fixed delay before the precharge relay is closed
+
+//Bus voltage of an RC precharge, final voltage set by the battery and any load on the bus
+struct Bus
+{
+    float ubat;
+    float ufinal;
+    float tauMs;
+    float noise;
+    uint32_t seed;
+
+    float Sample(uint32_t t)
+    {
+        seed = seed * 1103515245 + 12345;
+        float n = noise * (((seed >> 16) & 0xFF) / 127.5f - 1);
+        return ufinal * (1 - expf(-(float)t / tauMs)) + n;
+    }
+};
+
+//Runs the engine until it leaves PCH_RUNNING, returns the time that took
+static uint32_t Simulate(Bus bus, bool knownBattery, Precharge::State& result)
+{
+    uint32_t t = 0;
+
+    Precharge::Start(0);
+    do
+    {
+        t += PCH_PERIOD_MS;
+        result = Precharge::Run(bus.Sample(t), knownBattery ? bus.ubat : 0, UDCSW, TOL, TIMEOUT_MS, TAU_MIN_MS);
+    } while (result == Precharge::PCH_RUNNING);
+
+    return t;
+}
+
+//What MOD_PRECHARGE did before: relay delay, then wait for udc >= udcsw
+static uint32_t SimulateLegacy(Bus bus, float udcsw)
+{
+    for (uint32_t t = PCH_PERIOD_MS; t <= TIMEOUT_MS; t += PCH_PERIOD_MS)
+    {
+        if (bus.Sample(t) >= udcsw) return t + RLYDLY_MS;
+    }
+    return 0;
+}
+
+static void TestDoneWithinTolerance()
+{
+    Bus bus = { 360, 360, 200, 0, 1 };
+    Precharge::State result;
+    uint32_t t = Simulate(bus, true, result);
+    //360 * e^(-t/200) <= 10 at t = 717ms
+    ASSERT(result == Precharge::PCH_DONE && t >= 710 && t <= 730);
+}
+
+static void TestEstimatesTauAndFinalVoltage()
+{
+    Bus bus = { 360, 360, 200, 0.5f, 1 };
+    Precharge::State result;
+    Simulate(bus, true, result);
+    ASSERT(Precharge::HasEstimate() && fabsf(Precharge::GetTau() - 200) < 20 && fabsf(Precharge::GetFinal() - 360) < 5);
+}
+
+static void TestWithoutBatteryVoltageWaitsForUdcsw()
+{
+    Bus bus = { 360, 360, 200, 0.5f, 1 };
+    Precharge::State result;
+    uint32_t t = Simulate(bus, false, result);
+    //360 * (1 - e^(-t/200)) >= 330 at t = 497ms, the fit alone doesn't finish early
+    ASSERT(result == Precharge::PCH_DONE && t >= 490 && t <= 510);
+}
+
+static void TestLoadWithoutBatteryVoltageFails()
+{
+    //No battery voltage to compare with, the curve settling below udcsw gives it away
+    Bus bus = { 360, 120, 100, 0.5f, 1 };
+    Precharge::State result;
+    uint32_t t = Simulate(bus, false, result);
+    ASSERT(result == Precharge::PCH_FAILLOAD && t < TIMEOUT_MS / 4);
+}
+
+static void TestChargedBusIsDoneImmediately()
+{
+    Precharge::Start(350);
+    ASSERT(Precharge::Run(355, 360, UDCSW, TOL, TIMEOUT_MS, TAU_MIN_MS) == Precharge::PCH_DONE);
+}
+
+static void TestLoadOnBusFailsEarly()
+{
+    //Something on the bus draws current, the resistor divides the voltage down to 120V
+    Bus bus = { 360, 120, 100, 0.5f, 1 };
+    Precharge::State result;
+    uint32_t t = Simulate(bus, true, result);
+    ASSERT(result == Precharge::PCH_FAILLOAD && t < TIMEOUT_MS / 4);
+}
+
+static void TestMissingResistorFailsFast()
+{
+    Bus bus = { 360, 360, 2, 0, 1 };
+    Precharge::State result;
+    uint32_t t = Simulate(bus, true, result);
+    ASSERT(result == Precharge::PCH_FAILFAST && t < 200);
+}
+
+static void TestSlowPrechargeFailsBeforeTimeout()
+{
+    //Would need 3.6s to get within tolerance
+    Bus bus = { 360, 360, 1000, 0.5f, 1 };
+    Precharge::State result;
+    uint32_t t = Simulate(bus, true, result);
+    ASSERT(result == Precharge::PCH_FAILSLOW && t < TIMEOUT_MS / 2);
+}
+
+static void TestTimeToRunComparedToLegacy()
+{
+    //Full pack, udcsw set low enough for an empty one: legacy closes with 70V still missing
+    Bus full = { 400, 400, 200, 0.5f, 1 };
+    Precharge::State result;
+    uint32_t adaptive = Simulate(full, true, result);
+    uint32_t legacy = SimulateLegacy(full, 330);
+    cout << "Full pack: adaptive " << adaptive << "ms to 10V, legacy " << legacy << "ms to 70V" << endl;
+    ASSERT(result == Precharge::PCH_DONE && adaptive < legacy + 300);
+
+    //Empty pack below udcsw: legacy never gets there
+    Bus empty = { 320, 320, 200, 0.5f, 1 };
+    adaptive = Simulate(empty, true, result);
+    legacy = SimulateLegacy(empty, 330);
+    cout << "Empty pack: adaptive " << adaptive << "ms, legacy " << (legacy ? "done" : "timeout") << endl;
+    ASSERT(result == Precharge::PCH_DONE && legacy == 0);
+
+    //udcsw close to the pack voltage
+    Bus tight = { 360, 360, 200, 0.5f, 1 };
+    adaptive = Simulate(tight, true, result);
+    legacy = SimulateLegacy(tight, 350);
+    cout << "udcsw 350V: adaptive " << adaptive << "ms, legacy " << legacy << "ms" << endl;
+    ASSERT(result == Precharge::PCH_DONE && adaptive < legacy);
+}
+
+void PrechargeTest::RunTest()
+{
+    TestDoneWithinTolerance();
+    TestEstimatesTauAndFinalVoltage();
+    TestWithoutBatteryVoltageWaitsForUdcsw();
+    TestLoadWithoutBatteryVoltageFails();
+    TestChargedBusIsDoneImmediately();
+    TestLoadOnBusFailsEarly();
+    TestMissingResistorFailsFast();
+    TestSlowPrechargeFailsBeforeTimeout();
+    TestTimeToRunComparedToLegacy();
+}
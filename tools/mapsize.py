@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+#
+# This file is part of the ZombieVerter project.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""Flash and RAM usage from the linker map (linker.map, written by every link).
+
+  mapsize.py                          totals and the 20 largest objects
+  mapsize.py --objects 0              totals only
+  mapsize.py --symbols Slot NoInverter  sizes of the matching variables/functions
+
+Flash is .text, .rodata and the .data initialisers, RAM is .data and .bss.
+Run it before and after a change to compare, e.g. "make mapsize".
+"""
+
+import argparse
+import re
+import sys
+from collections import defaultdict
+
+FLASH = (".text", ".rodata", ".ARM", ".init_array", ".fini_array")
+RAM = (".bss", ".noinit")
+BOTH = (".data",)
+
+# " .bss._ZL11inverterSlot  0x20000abc  0x1c8 obj/full/stm32_vcu.o", the name may be on its own line
+INPUT = re.compile(r"^ ([.\w]\S*)?\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S+\.o\)?)\s*$")
+OUTPUT = re.compile(r"^(\.\S+)\s+0x[0-9a-f]+\s+0x[0-9a-f]+")
+
+
+def kind(section):
+    for prefix in FLASH:
+        if section.startswith(prefix):
+            return "flash"
+    for prefix in BOTH:
+        if section.startswith(prefix):
+            return "both"
+    for prefix in RAM:
+        if section.startswith(prefix):
+            return "ram"
+    return None
+
+
+def parse(path):
+    """Yields (output section, input section, size, object file)"""
+    output = None
+    pending = None
+    started = False
+
+    with open(path) as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if line.startswith("Linker script and memory map"):
+                started = True
+                continue
+            if not started:
+                continue
+
+            m = OUTPUT.match(line)
+            if m or (line.startswith(".") and " " not in line):
+                output = line.split()[0]
+                continue
+
+            m = INPUT.match(line)
+            if m:
+                name = m.group(1) or pending
+                pending = None
+                size = int(m.group(3), 16)
+                if name and size > 0:
+                    yield output, name, size, m.group(4)
+            elif re.match(r"^ \.\S+$", line):
+                pending = line.strip()
+            else:
+                pending = None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("map", nargs="?", default="linker.map")
+    parser.add_argument("--objects", type=int, default=20, help="number of objects to list")
+    parser.add_argument("--symbols", nargs="*", default=[], help="list input sections containing these names")
+    args = parser.parse_args()
+
+    flash = ram = 0
+    perObject = defaultdict(lambda: [0, 0])
+    symbols = []
+
+    for output, name, size, obj in parse(args.map):
+        k = kind(output or name)
+        if k is None:
+            continue
+        f = size if k in ("flash", "both") else 0
+        r = size if k in ("ram", "both") else 0
+        flash += f
+        ram += r
+        perObject[obj][0] += f
+        perObject[obj][1] += r
+        if any(s in name for s in args.symbols):
+            symbols.append((name, k, size, obj))
+
+    print("flash %7d  ram %6d  total" % (flash, ram))
+
+    if args.objects > 0:
+        largest = sorted(perObject.items(), key=lambda i: i[1][0] + i[1][1], reverse=True)
+        for obj, (f, r) in largest[:args.objects]:
+            print("flash %7d  ram %6d  %s" % (f, r, obj))
+
+    for name, k, size, obj in symbols:
+        print("%-5s %7d  %s (%s)" % (k, size, name, obj))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
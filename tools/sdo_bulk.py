@@ -0,0 +1,293 @@
+#!/usr/bin/env python3
+#
+# This file is part of the ZombieVerter project.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""Host side client for the bulk SDO channel (src/bulksdo.cpp).
+
+Examples (python-can, socketcan on can0, VCU CAN1 at 500k):
+
+  sdo_bulk.py params                      dump parameter set as id=value
+  sdo_bulk.py params --names params.json  ... with names from the "json" terminal command
+  sdo_bulk.py params --save set.bin       raw parameter set to file
+  sdo_bulk.py restore set.bin             write a saved set back (block download)
+  sdo_bulk.py blackbox                    black box recording as CSV
+  sdo_bulk.py faults                      fault history and occurrence counters
+  sdo_bulk.py upload 0x5001 --segmented   raw object upload using segmented transfer
+
+Estimated throughput on CAN1 at 500 kbit/s (125 bit per frame, 250 us):
+  expedited (CanSdo, 4 byte/round trip, ~1.5 ms with a USB adapter)   ~2.7 kB/s
+  segmented (7 byte/round trip)                                       ~4.7 kB/s
+  block upload, 2 frames/ms pacing, blksize 127                       ~13.8 kB/s
+"""
+
+import argparse
+import json
+import struct
+import sys
+import time
+
+NODEID = 4
+REQ_ID = 0x600 + NODEID
+REP_ID = 0x580 + NODEID
+PARAM_INDEX = 0x5000
+BLACKBOX_INDEX = 0x5001
+FAULTS_INDEX = 0x5002
+BB_SIGNALS = ["opmode", "dir", "status", "TorqDerate", "din_brake", "T15Stat", "pot", "pot2",
+              "potnom", "torque", "speed", "udc", "udc2", "idc", "tmphs", "tmpm"]
+BB_SCALES = [1, 1, 1, 1, 1, 1, 1, 1, 10, 1, 1, 10, 10, 1, 1, 1]
+BB_REASONS = ["none", "precharge", "overvoltage", "rundrop", "cantimeout", "manual"]
+ERRORS = ["NONE", "BMS_COMM", "GFM_COMM", "INV_COMM", "i3LIM_COMM", "HVCU_COMM", "VEHICLE_COMM",
+          "CHARGER_COMM", "OVERVOLTAGE", "ISOLATION", "PRECHARGE", "THROTTLE1", "THROTTLE2",
+          "THROTTLE12", "THROTTLE12DIFF", "THROTTLEMODE", "CANTIMEOUT", "TMPHSMAX", "TMPMMAX",
+          "WATCHDOG", "NODRIVER", "PRECHARGELOAD", "PRECHARGEFAST"]
+
+
+class SdoError(Exception):
+    pass
+
+
+class BulkSdoClient:
+    """bus needs send(bytes) and recv(timeout) -> bytes or None"""
+
+    def __init__(self, bus, timeout=1.0):
+        self.bus = bus
+        self.timeout = timeout
+
+    def _request(self, data):
+        self.bus.send(bytes(data).ljust(8, b"\0"))
+        return self._response()
+
+    def _response(self):
+        data = self.bus.recv(self.timeout)
+        if data is None:
+            raise SdoError("timeout")
+        if data[0] == 0x80:
+            raise SdoError("abort 0x%08x" % struct.unpack_from("<I", data, 4)[0])
+        return data
+
+    def upload(self, index, block=True, blksize=127):
+        return self._block_upload(index, blksize) if block else self._segmented_upload(index)
+
+    def download(self, index, data, block=True):
+        if block:
+            self._block_download(index, data)
+        else:
+            self._segmented_download(index, data)
+
+    def _segmented_upload(self, index):
+        rep = self._request(struct.pack("<BHB", 0x40, index, 0))
+        if rep[0] & 0xE0 != 0x40:
+            raise SdoError("unexpected response 0x%02x" % rep[0])
+        if rep[0] & 0x02:
+            return bytes(rep[4:8 - ((rep[0] >> 2) & 3)])
+        size = struct.unpack_from("<I", rep, 4)[0]
+        result = bytearray()
+        toggle = 0
+        while True:
+            rep = self._request([0x60 | toggle])
+            if rep[0] & 0x10 != toggle:
+                raise SdoError("toggle bit mismatch")
+            result += rep[1:8 - ((rep[0] >> 1) & 7)]
+            toggle ^= 0x10
+            if rep[0] & 0x01:
+                break
+        if len(result) != size:
+            raise SdoError("size mismatch, got %d expected %d" % (len(result), size))
+        return bytes(result)
+
+    def _block_upload(self, index, blksize):
+        rep = self._request(struct.pack("<BHBBB", 0xA0, index, 0, blksize, 0))
+        if rep[0] & 0xE1 != 0xC0:
+            raise SdoError("unexpected response 0x%02x" % rep[0])
+        size = struct.unpack_from("<I", rep, 4)[0]
+        self.bus.send(bytes([0xA3]).ljust(8, b"\0"))
+        result = bytearray()
+        while True:
+            block = bytearray()
+            ackseq = 0
+            last = False
+            while True:
+                seg = self.bus.recv(self.timeout)
+                if seg is None:
+                    raise SdoError("timeout in block")
+                seq = seg[0] & 0x7F
+                if seq == ackseq + 1:
+                    ackseq = seq
+                    block += seg[1:8]
+                    last = (seg[0] & 0x80) != 0
+                if last or seq >= blksize:
+                    break
+            result += block
+            self.bus.send(bytes([0xA2, ackseq, blksize]).ljust(8, b"\0"))
+            if last:
+                break
+        rep = self._response()
+        if rep[0] & 0xE3 != 0xC1:
+            raise SdoError("unexpected end 0x%02x" % rep[0])
+        unused = (rep[0] >> 2) & 7
+        if unused:
+            del result[-unused:]
+        self.bus.send(bytes([0xA1]).ljust(8, b"\0"))
+        if len(result) != size:
+            raise SdoError("size mismatch, got %d expected %d" % (len(result), size))
+        return bytes(result)
+
+    def _segmented_download(self, index, data):
+        rep = self._request(struct.pack("<BHBI", 0x21, index, 0, len(data)))
+        if rep[0] != 0x60:
+            raise SdoError("unexpected response 0x%02x" % rep[0])
+        toggle = 0
+        pos = 0
+        while True:
+            chunk = data[pos:pos + 7]
+            pos += len(chunk)
+            last = pos >= len(data)
+            cmd = toggle | ((7 - len(chunk)) << 1) | (1 if last else 0)
+            rep = self._request(bytes([cmd]) + chunk)
+            if rep[0] != 0x20 | toggle:
+                raise SdoError("unexpected response 0x%02x" % rep[0])
+            toggle ^= 0x10
+            if last:
+                break
+
+    def _block_download(self, index, data):
+        rep = self._request(struct.pack("<BHBI", 0xC2, index, 0, len(data)))
+        if rep[0] & 0xE3 != 0xA0:
+            raise SdoError("unexpected response 0x%02x" % rep[0])
+        blksize = rep[4]
+        segments = [data[i:i + 7] for i in range(0, len(data), 7)] or [b""]
+        pos = 0
+        while pos < len(segments):
+            count = min(blksize, len(segments) - pos)
+            for seq in range(1, count + 1):
+                seg = segments[pos + seq - 1]
+                last = pos + seq == len(segments)
+                self.bus.send(bytes([(0x80 if last else 0) | seq]) + seg.ljust(7, b"\0"))
+            rep = self._response()
+            if rep[0] != 0xA2:
+                raise SdoError("unexpected response 0x%02x" % rep[0])
+            pos += rep[1]
+            blksize = rep[2]
+        unused = 7 - len(segments[-1])
+        rep = self._request([0xC1 | (unused << 2)])
+        if rep[0] != 0xA1:
+            raise SdoError("unexpected response 0x%02x" % rep[0])
+
+
+def decode_params(data):
+    return [struct.unpack_from("<Hi", data, i) for i in range(0, len(data) - 5, 6)]
+
+
+def decode_blackbox(data):
+    state, reason, samples, post, trgtime = struct.unpack_from("<BBBBI", data)
+    rows = [struct.unpack_from("<%dh" % len(BB_SIGNALS), data, 8 + i * 2 * len(BB_SIGNALS))
+            for i in range(samples)]
+    trigger = samples - post if state != 0 else -1
+    return state, reason, trgtime, trigger, rows
+
+
+def decode_faults(data):
+    numerrors, numentries = struct.unpack_from("<BB", data)
+    counts = struct.unpack_from("<%dH" % numerrors, data, 2)
+    start = 2 + 2 * numerrors
+    entries = [struct.unpack_from("<IBBHHhhh", data, start + i * 16) for i in range(numentries)]
+    return counts, entries
+
+
+def error_name(err):
+    return ERRORS[err] if err < len(ERRORS) else str(err)
+
+
+class CanBus:
+    def __init__(self, interface, channel, bitrate):
+        import can
+        self.can = can
+        self.bus = can.interface.Bus(interface=interface, channel=channel, bitrate=bitrate,
+                                     can_filters=[{"can_id": REP_ID, "can_mask": 0x7FF}])
+
+    def send(self, data):
+        self.bus.send(self.can.Message(arbitration_id=REQ_ID, data=data, is_extended_id=False))
+
+    def recv(self, timeout):
+        end = time.monotonic() + timeout
+        while True:
+            msg = self.bus.recv(max(0, end - time.monotonic()))
+            if msg is None:
+                return None
+            if msg.arbitration_id == REP_ID:
+                return bytes(msg.data).ljust(8, b"\0")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="ZombieVerter bulk SDO client")
+    parser.add_argument("command", choices=["params", "restore", "blackbox", "faults", "upload"])
+    parser.add_argument("arg", nargs="?", help="file for restore, index for upload")
+    parser.add_argument("--interface", default="socketcan")
+    parser.add_argument("--channel", default="can0")
+    parser.add_argument("--bitrate", type=int, default=500000)
+    parser.add_argument("--segmented", action="store_true", help="use segmented instead of block transfer")
+    parser.add_argument("--names", help="parameter json from the \"json\" terminal command")
+    parser.add_argument("--save", help="write raw data to file")
+    args = parser.parse_args()
+
+    client = BulkSdoClient(CanBus(args.interface, args.channel, args.bitrate))
+    block = not args.segmented
+    start = time.monotonic()
+
+    if args.command == "restore":
+        with open(args.arg, "rb") as f:
+            data = f.read()
+        client.download(PARAM_INDEX, data, block)
+    else:
+        index = {"params": PARAM_INDEX, "blackbox": BLACKBOX_INDEX, "faults": FAULTS_INDEX}.get(args.command)
+        if index is None:
+            index = int(args.arg, 0)
+        data = client.upload(index, block)
+
+    elapsed = time.monotonic() - start
+    print("%d bytes in %.3f s, %.1f kB/s" % (len(data), elapsed, len(data) / elapsed / 1000), file=sys.stderr)
+
+    if args.save:
+        with open(args.save, "wb") as f:
+            f.write(data)
+    elif args.command == "params":
+        names = {}
+        if args.names:
+            with open(args.names) as f:
+                names = {v["id"]: k for k, v in json.load(f).items() if "id" in v}
+        for pid, value in decode_params(data):
+            print("%s=%g" % (names.get(pid, pid), value / 32.0))
+    elif args.command == "blackbox":
+        state, reason, trgtime, trigger, rows = decode_blackbox(data)
+        print("# state=%d reason=%s time=%d trigger=%d" % (state, BB_REASONS[reason], trgtime, trigger))
+        print("n," + ",".join(BB_SIGNALS))
+        for i, row in enumerate(rows):
+            print("%d," % (i - trigger) + ",".join("%g" % (v / s) for v, s in zip(row, BB_SCALES)))
+    elif args.command == "faults":
+        counts, entries = decode_faults(data)
+        for err, count in enumerate(counts):
+            if count > 0:
+                print("# %s: %d" % (error_name(err), count))
+        print("uptime,day,time,error,count,opmode,speed,udc,idc")
+        for uptime, err, opmode, count, clock, speed, udc, idc in entries:
+            print("%d,%d,%02d:%02d,%s,%d,%d,%d,%d,%d" % (uptime, clock // 1440 % 7, clock // 60 % 24, clock % 60,
+                                                      error_name(err), count, opmode, speed, udc, idc))
+    elif args.command == "upload":
+        sys.stdout.write(data.hex() + "\n")
+
+
+if __name__ == "__main__":
+    main()